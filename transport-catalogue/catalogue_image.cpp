@@ -0,0 +1,400 @@
+#include "catalogue_image.h"
+#include "serialization.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <type_traits>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace transport_catalogue {
+
+using namespace std::literals;
+
+namespace image_layout {
+
+//Все секции выровнены на 8 байт, смещения отсчитываются от начала файла
+struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint64_t file_size;
+    uint32_t stops_count;
+    uint32_t buses_count;
+    uint32_t stops_table_size; //Степень двойки
+    uint32_t buses_table_size;
+    uint64_t names_size;
+    uint64_t bus_stops_count;
+    uint64_t stop_buses_count;
+    uint64_t names_offset;
+    uint64_t stops_offset;
+    uint64_t stops_table_offset;
+    uint64_t buses_offset;
+    uint64_t buses_table_offset;
+    uint64_t bus_stops_offset;
+    uint64_t stop_buses_offset;
+};
+
+struct Stop {
+    uint64_t name_offset; //Относительно секции имён
+    uint32_t name_size;
+    uint32_t buses_begin; //Номера маршрутов в секции stop_buses, по возрастанию имени
+    double lat;
+    double lng;
+    uint32_t buses_count;
+    uint32_t reserved;
+};
+
+struct Bus {
+    uint64_t name_offset;
+    uint32_t name_size;
+    uint32_t stops_begin; //Номера остановок прямого хода в секции bus_stops
+    uint32_t stops_count;
+    uint8_t is_roundtrip;
+    uint8_t reserved[3];
+    uint64_t stops_on_route;
+    uint64_t unique_stops;
+    double length;
+    double curvature;
+};
+
+} //image_layout
+
+namespace {
+
+constexpr char IMAGE_MAGIC[8] = {'T', 'C', 'A', 'T', 'I', 'M', 'G', '\0'};
+constexpr uint32_t IMAGE_VERSION = 2; //С версии 2 маршрут хранит только прямой ход
+constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+constexpr uint32_t EMPTY_ENTRY = UINT32_MAX;
+
+uint64_t HashName(std::string_view name) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (const unsigned char c : name) {
+        hash ^= c;
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+uint32_t GetTableSize(size_t count) {
+    uint32_t size = 1;
+    while (size < 2 * count) {
+        size *= 2;
+    }
+    return size;
+}
+
+//Хеш-таблица с линейным пробированием из номеров записей
+std::vector<uint32_t> MakeTable(const std::vector<std::string_view>& names) {
+    std::vector<uint32_t> table(GetTableSize(names.size()), EMPTY_ENTRY);
+    const size_t mask = table.size() - 1;
+    for (uint32_t i = 0; i < names.size(); ++i) {
+        size_t index = HashName(names[i]) & mask;
+        while (table[index] != EMPTY_ENTRY) {
+            index = (index + 1) & mask;
+        }
+        table[index] = i;
+    }
+    return table;
+}
+
+template <typename Value>
+uint64_t AppendSection(std::string& buffer, const std::vector<Value>& values) {
+    static_assert(std::is_trivially_copyable_v<Value>);
+    buffer.resize((buffer.size() + 7) / 8 * 8, '\0');
+    const uint64_t offset = buffer.size();
+    buffer.append(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(Value));
+    return offset;
+}
+
+} //namespace
+
+void SaveCatalogueImage(const std::string& path, const TransportCatalogue& catalogue) {
+    const auto& stops = catalogue.GetStops();
+    const auto& buses = catalogue.GetBuses();
+
+    std::string names;
+    std::vector<std::string_view> stop_names;
+    std::vector<image_layout::Stop> image_stops;
+    for (const Stop& stop : stops) {
+        image_stops.push_back({names.size(), static_cast<uint32_t>(stop.name.size()), 0, stop.coordinates.lat, stop.coordinates.lng, 0, 0});
+        names.append(stop.name);
+        stop_names.push_back(stop.name);
+    }
+
+    //Маршруты остановки упорядочены по имени, как в ответе на запрос Stop
+    std::vector<uint32_t> bus_order(buses.size());
+    for (uint32_t i = 0; i < bus_order.size(); ++i) {
+        bus_order[i] = i;
+    }
+    std::sort(bus_order.begin(), bus_order.end(), [&buses](uint32_t lhs, uint32_t rhs) { return buses[lhs].name < buses[rhs].name; });
+    std::vector<std::vector<uint32_t>> buses_for_stop(stops.size());
+    for (uint32_t bus : bus_order) {
+        for (StopId stop : catalogue.GetBusStops(buses[bus])) {
+            auto& stop_buses = buses_for_stop[stop];
+            if (stop_buses.empty() || stop_buses.back() != bus) {
+                stop_buses.push_back(bus);
+            }
+        }
+    }
+    std::vector<uint32_t> stop_buses;
+    for (StopId id = 0; id < stops.size(); ++id) {
+        image_stops[id].buses_begin = static_cast<uint32_t>(stop_buses.size());
+        image_stops[id].buses_count = static_cast<uint32_t>(buses_for_stop[id].size());
+        stop_buses.insert(stop_buses.end(), buses_for_stop[id].begin(), buses_for_stop[id].end());
+    }
+
+    std::vector<std::string_view> bus_names;
+    std::vector<image_layout::Bus> image_buses;
+    std::vector<StopId> bus_stops;
+    for (const Bus& bus : buses) {
+        image_layout::Bus image_bus{};
+        image_bus.name_offset = names.size();
+        image_bus.name_size = static_cast<uint32_t>(bus.name.size());
+        image_bus.stops_begin = static_cast<uint32_t>(bus_stops.size());
+        const StopSequence stops = catalogue.GetBusStops(bus);
+        image_bus.stops_count = static_cast<uint32_t>(stops.size());
+        image_bus.is_roundtrip = bus.is_roundtrip;
+        image_bus.stops_on_route = bus.info.stops_on_route;
+        image_bus.unique_stops = bus.info.unique_stops;
+        image_bus.length = bus.info.length;
+        image_bus.curvature = bus.info.curvature;
+        image_buses.push_back(image_bus);
+        names.append(bus.name);
+        bus_names.push_back(bus.name);
+        bus_stops.insert(bus_stops.end(), stops.begin(), stops.end());
+    }
+    const std::vector<uint32_t> stops_table = MakeTable(stop_names);
+    const std::vector<uint32_t> buses_table = MakeTable(bus_names);
+
+    image_layout::Header header{};
+    std::memcpy(header.magic, IMAGE_MAGIC, sizeof(IMAGE_MAGIC));
+    header.version = IMAGE_VERSION;
+    header.byte_order = BYTE_ORDER_MARK;
+    header.stops_count = static_cast<uint32_t>(image_stops.size());
+    header.buses_count = static_cast<uint32_t>(image_buses.size());
+    header.stops_table_size = static_cast<uint32_t>(stops_table.size());
+    header.buses_table_size = static_cast<uint32_t>(buses_table.size());
+    header.names_size = names.size();
+    header.bus_stops_count = bus_stops.size();
+    header.stop_buses_count = stop_buses.size();
+
+    std::string buffer(sizeof(header), '\0');
+    header.names_offset = AppendSection(buffer, std::vector<char>(names.begin(), names.end()));
+    header.stops_offset = AppendSection(buffer, image_stops);
+    header.stops_table_offset = AppendSection(buffer, stops_table);
+    header.buses_offset = AppendSection(buffer, image_buses);
+    header.buses_table_offset = AppendSection(buffer, buses_table);
+    header.bus_stops_offset = AppendSection(buffer, bus_stops);
+    header.stop_buses_offset = AppendSection(buffer, stop_buses);
+    header.file_size = buffer.size();
+    std::memcpy(buffer.data(), &header, sizeof(header));
+
+    std::ofstream output(path, std::ios::binary);
+    output.write(buffer.data(), buffer.size());
+    if (!output) {
+        throw SnapshotError("Cannot write catalogue image "s + path);
+    }
+}
+
+CatalogueImage::CatalogueImage(const std::string& path) {
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw SnapshotError("Cannot open catalogue image "s + path);
+    }
+    struct stat file_stat{};
+    if (fstat(fd, &file_stat) != 0 || static_cast<size_t>(file_stat.st_size) < sizeof(image_layout::Header)) {
+        close(fd);
+        throw SnapshotError("Catalogue image "s + path + " is too short"s);
+    }
+    size_ = file_stat.st_size;
+    //MAP_SHARED: страницы берутся из кеша файла и не копируются в каждый процесс
+    void* data = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        throw SnapshotError("Cannot map catalogue image "s + path);
+    }
+    data_ = static_cast<const char*>(data);
+    header_ = reinterpret_cast<const image_layout::Header*>(data_);
+    try {
+        Validate();
+    }
+    catch (...) {
+        munmap(const_cast<char*>(data_), size_);
+        throw;
+    }
+}
+
+CatalogueImage::~CatalogueImage() {
+    munmap(const_cast<char*>(data_), size_);
+}
+
+template <typename Value>
+const Value* CatalogueImage::GetSection(uint64_t offset) const {
+    return reinterpret_cast<const Value*>(data_ + offset);
+}
+
+//Проверяет заголовок и все смещения, чтобы повреждённый файл не приводил к чтению за его пределами
+void CatalogueImage::Validate() const {
+    if (std::memcmp(header_->magic, IMAGE_MAGIC, sizeof(IMAGE_MAGIC)) != 0) {
+        throw SnapshotError("Not a catalogue image"s);
+    }
+    if (header_->byte_order != BYTE_ORDER_MARK) {
+        throw SnapshotError("Catalogue image has a different byte order"s);
+    }
+    if (header_->version != IMAGE_VERSION) {
+        throw SnapshotError("Unsupported catalogue image version "s + std::to_string(header_->version));
+    }
+    if (header_->file_size != size_) {
+        throw SnapshotError("Catalogue image is truncated"s);
+    }
+    auto check_section = [this](uint64_t offset, uint64_t count, size_t value_size) {
+        if (offset % 8 != 0 || offset > size_ || count > (size_ - offset) / value_size) {
+            throw SnapshotError("Catalogue image section is out of bounds"s);
+        }
+    };
+    const auto is_power_of_two = [](uint32_t value) { return value != 0 && (value & (value - 1)) == 0; };
+    if (!is_power_of_two(header_->stops_table_size) || !is_power_of_two(header_->buses_table_size)) {
+        throw SnapshotError("Catalogue image has a broken name table"s);
+    }
+    check_section(header_->names_offset, header_->names_size, 1);
+    check_section(header_->stops_offset, header_->stops_count, sizeof(image_layout::Stop));
+    check_section(header_->stops_table_offset, header_->stops_table_size, sizeof(uint32_t));
+    check_section(header_->buses_offset, header_->buses_count, sizeof(image_layout::Bus));
+    check_section(header_->buses_table_offset, header_->buses_table_size, sizeof(uint32_t));
+    check_section(header_->bus_stops_offset, header_->bus_stops_count, sizeof(StopId));
+    check_section(header_->stop_buses_offset, header_->stop_buses_count, sizeof(uint32_t));
+
+    auto check_range = [](uint64_t begin, uint64_t count, uint64_t size) {
+        if (begin > size || count > size - begin) {
+            throw SnapshotError("Catalogue image record is out of bounds"s);
+        }
+    };
+    const auto* stops = GetSection<image_layout::Stop>(header_->stops_offset);
+    for (uint32_t i = 0; i < header_->stops_count; ++i) {
+        check_range(stops[i].name_offset, stops[i].name_size, header_->names_size);
+        check_range(stops[i].buses_begin, stops[i].buses_count, header_->stop_buses_count);
+    }
+    const auto* buses = GetSection<image_layout::Bus>(header_->buses_offset);
+    for (uint32_t i = 0; i < header_->buses_count; ++i) {
+        check_range(buses[i].name_offset, buses[i].name_size, header_->names_size);
+        check_range(buses[i].stops_begin, buses[i].stops_count, header_->bus_stops_count);
+    }
+    const auto* bus_stops = GetSection<StopId>(header_->bus_stops_offset);
+    for (uint64_t i = 0; i < header_->bus_stops_count; ++i) {
+        check_range(bus_stops[i], 1, header_->stops_count);
+    }
+    const auto* stop_buses = GetSection<uint32_t>(header_->stop_buses_offset);
+    for (uint64_t i = 0; i < header_->stop_buses_count; ++i) {
+        check_range(stop_buses[i], 1, header_->buses_count);
+    }
+    const auto* stops_table = GetSection<uint32_t>(header_->stops_table_offset);
+    for (uint32_t i = 0; i < header_->stops_table_size; ++i) {
+        if (stops_table[i] != EMPTY_ENTRY) {
+            check_range(stops_table[i], 1, header_->stops_count);
+        }
+    }
+    const auto* buses_table = GetSection<uint32_t>(header_->buses_table_offset);
+    for (uint32_t i = 0; i < header_->buses_table_size; ++i) {
+        if (buses_table[i] != EMPTY_ENTRY) {
+            check_range(buses_table[i], 1, header_->buses_count);
+        }
+    }
+}
+
+std::string_view CatalogueImage::GetName(uint64_t offset, uint32_t size) const {
+    return {data_ + header_->names_offset + offset, size};
+}
+
+size_t CatalogueImage::GetStopsCount() const {
+    return header_->stops_count;
+}
+
+size_t CatalogueImage::GetBusesCount() const {
+    return header_->buses_count;
+}
+
+Stop CatalogueImage::GetStop(StopId id) const {
+    const image_layout::Stop& stop = GetSection<image_layout::Stop>(header_->stops_offset)[id];
+    return {GetName(stop.name_offset, stop.name_size), {stop.lat, stop.lng}, id};
+}
+
+ImageBus CatalogueImage::GetBus(uint32_t index) const {
+    const image_layout::Bus& bus = GetSection<image_layout::Bus>(header_->buses_offset)[index];
+    return {GetName(bus.name_offset, bus.name_size),
+            {GetSection<StopId>(header_->bus_stops_offset) + bus.stops_begin, bus.stops_count},
+            {bus.stops_on_route, bus.unique_stops, bus.length, bus.curvature},
+            bus.is_roundtrip != 0};
+}
+
+std::optional<uint32_t> CatalogueImage::FindStopIndex(std::string_view name) const {
+    const auto* table = GetSection<uint32_t>(header_->stops_table_offset);
+    const auto* stops = GetSection<image_layout::Stop>(header_->stops_offset);
+    const size_t mask = header_->stops_table_size - 1;
+    //Таблица заполнена не больше чем наполовину, поэтому пустая запись всегда найдётся
+    for (size_t index = HashName(name) & mask; table[index] != EMPTY_ENTRY; index = (index + 1) & mask) {
+        const image_layout::Stop& stop = stops[table[index]];
+        if (GetName(stop.name_offset, stop.name_size) == name) {
+            return table[index];
+        }
+    }
+    return std::nullopt;
+}
+
+std::optional<uint32_t> CatalogueImage::FindBusIndex(std::string_view name) const {
+    const auto* table = GetSection<uint32_t>(header_->buses_table_offset);
+    const auto* buses = GetSection<image_layout::Bus>(header_->buses_offset);
+    const size_t mask = header_->buses_table_size - 1;
+    for (size_t index = HashName(name) & mask; table[index] != EMPTY_ENTRY; index = (index + 1) & mask) {
+        const image_layout::Bus& bus = buses[table[index]];
+        if (GetName(bus.name_offset, bus.name_size) == name) {
+            return table[index];
+        }
+    }
+    return std::nullopt;
+}
+
+std::optional<Stop> CatalogueImage::FindStop(std::string_view name) const {
+    if (auto index = FindStopIndex(name)) {
+        return GetStop(*index);
+    }
+    return std::nullopt;
+}
+
+std::optional<ImageBus> CatalogueImage::FindBus(std::string_view name) const {
+    if (auto index = FindBusIndex(name)) {
+        return GetBus(*index);
+    }
+    return std::nullopt;
+}
+
+std::optional<BusInfo> CatalogueImage::GetBusInfo(std::string_view name) const {
+    if (auto bus = FindBus(name)) {
+        return bus->info;
+    }
+    return std::nullopt;
+}
+
+std::optional<std::pmr::set<std::string_view>> CatalogueImage::GetBusesForStop(std::string_view name, std::pmr::memory_resource* resource) const {
+    auto index = FindStopIndex(name);
+    if (!index) {
+        return std::nullopt;
+    }
+    const image_layout::Stop& stop = GetSection<image_layout::Stop>(header_->stops_offset)[*index];
+    const auto* buses = GetSection<image_layout::Bus>(header_->buses_offset);
+    const auto* stop_buses = GetSection<uint32_t>(header_->stop_buses_offset) + stop.buses_begin;
+    std::pmr::set<std::string_view> result(resource);
+    for (uint32_t i = 0; i < stop.buses_count; ++i) {
+        const image_layout::Bus& bus = buses[stop_buses[i]];
+        //Номера уже упорядочены по имени, поэтому вставка идёт в конец
+        result.insert(result.end(), GetName(bus.name_offset, bus.name_size));
+    }
+    return result;
+}
+
+} //transport_catalogue
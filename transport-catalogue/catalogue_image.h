@@ -0,0 +1,67 @@
+#pragma once
+
+#include "domain.h"
+#include "transport_catalogue.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <optional>
+#include <set>
+#include <span>
+#include <string>
+#include <string_view>
+
+namespace transport_catalogue {
+
+//Записи файла образа, описаны в catalogue_image.cpp
+namespace image_layout {
+struct Header;
+struct Stop;
+struct Bus;
+} //image_layout
+
+//Маршрут из образа каталога: имя и номера остановок прямого хода указывают прямо в отображённый файл
+struct ImageBus {
+    std::string_view name;
+    std::span<const StopId> stops;
+    BusInfo info;
+    bool is_roundtrip = false;
+};
+
+//Образ каталога только для чтения. Вместо указателей в нём смещения и номера, поэтому
+//файл отображается в память как есть, а страницы отображения общие для всех процессов хоста.
+//Содержит остановки, маршруты с готовой статистикой, маршруты каждой остановки и хеш-таблицы по именам.
+class CatalogueImage {
+public:
+    explicit CatalogueImage(const std::string& path); //SnapshotError, если файл не образ каталога
+    CatalogueImage(const CatalogueImage&) = delete;
+    CatalogueImage& operator=(const CatalogueImage&) = delete;
+    ~CatalogueImage();
+
+    size_t GetStopsCount() const;
+    size_t GetBusesCount() const;
+    Stop GetStop(StopId id) const;
+    std::optional<Stop> FindStop(std::string_view name) const;
+    std::optional<ImageBus> FindBus(std::string_view name) const;
+    std::optional<BusInfo> GetBusInfo(std::string_view name) const;
+    std::optional<std::pmr::set<std::string_view>> GetBusesForStop(std::string_view name,
+                                                                   std::pmr::memory_resource* resource = std::pmr::get_default_resource()) const;
+
+private:
+    template <typename Value>
+    const Value* GetSection(uint64_t offset) const;
+    std::string_view GetName(uint64_t offset, uint32_t size) const;
+    ImageBus GetBus(uint32_t index) const;
+    std::optional<uint32_t> FindStopIndex(std::string_view name) const;
+    std::optional<uint32_t> FindBusIndex(std::string_view name) const;
+    void Validate() const;
+
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    const image_layout::Header* header_ = nullptr;
+};
+
+void SaveCatalogueImage(const std::string& path, const TransportCatalogue& catalogue);
+
+} //transport_catalogue
@@ -0,0 +1,13 @@
+#include "catalogue_versions.h"
+
+namespace transport_catalogue {
+
+CatalogueVersions::CatalogueVersions(TransportCatalogue catalogue)
+    : current_(std::make_shared<const CatalogueSnapshot>(CatalogueSnapshot{0, std::move(catalogue)})) {
+}
+
+std::shared_ptr<const CatalogueSnapshot> CatalogueVersions::Get() const {
+    return current_.load();
+}
+
+} //transport_catalogue
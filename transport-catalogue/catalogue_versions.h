@@ -0,0 +1,49 @@
+#pragma once
+
+#include "transport_catalogue.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+namespace transport_catalogue {
+
+struct CatalogueSnapshot {
+    uint64_t version;
+    TransportCatalogue catalogue;
+};
+
+//Неизменяемые версии каталога для обновлений без остановки запросов (по схеме RCU).
+//Читатель берёт текущую версию атомарной загрузкой указателя и работает с ней сколько угодно;
+//писатель копирует последнюю версию, меняет копию и публикует её атомарной заменой указателя.
+//Старая версия освобождается, когда её отпускает последний читатель.
+//Копия каталога делит с исходным все данные и копирует только то, что меняет updater:
+//куски остановок, маршрутов, таблиц и индексов, затронутые изменением.
+class CatalogueVersions {
+public:
+    explicit CatalogueVersions(TransportCatalogue catalogue);
+
+    std::shared_ptr<const CatalogueSnapshot> Get() const;
+
+    //updater(TransportCatalogue&) применяет изменения к копии текущей версии
+    template <typename Updater>
+    uint64_t Update(Updater updater);
+
+private:
+    std::atomic<std::shared_ptr<const CatalogueSnapshot>> current_;
+    std::mutex update_mutex_; //Писатели обновляют по очереди
+};
+
+template <typename Updater>
+uint64_t CatalogueVersions::Update(Updater updater) {
+    std::lock_guard lock(update_mutex_);
+    const auto current = current_.load();
+    auto next = std::make_shared<CatalogueSnapshot>(CatalogueSnapshot{current->version + 1, current->catalogue});
+    updater(next->catalogue);
+    const uint64_t version = next->version;
+    current_.store(std::move(next));
+    return version;
+}
+
+} //transport_catalogue
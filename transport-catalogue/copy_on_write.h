@@ -0,0 +1,297 @@
+#pragma once
+
+#include "memory_usage.h"
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace transport_catalogue {
+
+namespace copy_on_write_detail {
+
+//Данные больше никто не держит: другие владельцы могли читать их в других потоках,
+//и их чтение должно завершиться до нашей записи
+template <typename T>
+bool IsUnique(const std::shared_ptr<T>& data) {
+    if (data.use_count() != 1) {
+        return false;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return true;
+}
+
+//Блок make_shared: счётчики ссылок и сам объект
+template <typename T>
+size_t SharedBytes() {
+    return memory::AllocationSize(sizeof(T) + 2 * sizeof(int) + sizeof(void*));
+}
+
+} //copy_on_write_detail
+
+//Массив из кусков по CHUNK_SIZE элементов, общих у копий массива.
+//Копия копирует указатели на куски, изменение элемента копирует только его кусок,
+//поэтому версии каталога делят все остановки и маршруты, которые не менялись между ними.
+template <typename T>
+class ChunkedVector {
+public:
+    static constexpr size_t CHUNK_SHIFT = 8;
+    static constexpr size_t CHUNK_SIZE = size_t{1} << CHUNK_SHIFT;
+
+    class Iterator {
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const T*;
+        using reference = const T&;
+
+        Iterator() = default;
+        Iterator(const ChunkedVector* vector, size_t index)
+            : vector_(vector), index_(index) {
+        }
+
+        reference operator*() const {
+            return (*vector_)[index_];
+        }
+        pointer operator->() const {
+            return &**this;
+        }
+        reference operator[](difference_type offset) const {
+            return (*vector_)[index_ + offset];
+        }
+        Iterator& operator++() {
+            ++index_;
+            return *this;
+        }
+        Iterator operator++(int) {
+            Iterator result = *this;
+            ++index_;
+            return result;
+        }
+        Iterator& operator--() {
+            --index_;
+            return *this;
+        }
+        Iterator operator--(int) {
+            Iterator result = *this;
+            --index_;
+            return result;
+        }
+        Iterator& operator+=(difference_type offset) {
+            index_ += offset;
+            return *this;
+        }
+        Iterator& operator-=(difference_type offset) {
+            index_ -= offset;
+            return *this;
+        }
+        friend Iterator operator+(Iterator it, difference_type offset) {
+            return it += offset;
+        }
+        friend Iterator operator+(difference_type offset, Iterator it) {
+            return it += offset;
+        }
+        friend Iterator operator-(Iterator it, difference_type offset) {
+            return it -= offset;
+        }
+        difference_type operator-(const Iterator& other) const {
+            return static_cast<difference_type>(index_) - static_cast<difference_type>(other.index_);
+        }
+        bool operator==(const Iterator& other) const {
+            return index_ == other.index_;
+        }
+        auto operator<=>(const Iterator& other) const {
+            return index_ <=> other.index_;
+        }
+
+    private:
+        const ChunkedVector* vector_ = nullptr;
+        size_t index_ = 0;
+    };
+
+    using value_type = T;
+    using const_iterator = Iterator;
+
+    size_t size() const {
+        return size_;
+    }
+    bool empty() const {
+        return size_ == 0;
+    }
+    const T& operator[](size_t index) const {
+        return (*chunks_[index >> CHUNK_SHIFT])[index & (CHUNK_SIZE - 1)];
+    }
+    const T& at(size_t index) const {
+        if (index >= size_) {
+            throw std::out_of_range("Chunked vector index is out of range");
+        }
+        return (*this)[index];
+    }
+    const T& front() const {
+        return (*this)[0];
+    }
+    const T& back() const {
+        return (*this)[size_ - 1];
+    }
+    Iterator begin() const {
+        return {this, 0};
+    }
+    Iterator end() const {
+        return {this, size_};
+    }
+
+    //Ссылка действительна до следующего изменения массива
+    T& Mutable(size_t index) {
+        return MutableChunk(index >> CHUNK_SHIFT)[index & (CHUNK_SIZE - 1)];
+    }
+    void push_back(T value) {
+        if ((size_ & (CHUNK_SIZE - 1)) == 0) {
+            chunks_.push_back(std::make_shared<Chunk>());
+            chunks_.back()->reserve(CHUNK_SIZE);
+        }
+        MutableChunk(chunks_.size() - 1).push_back(std::move(value));
+        ++size_;
+    }
+    void pop_back() {
+        --size_;
+        if ((size_ & (CHUNK_SIZE - 1)) == 0) {
+            chunks_.pop_back();
+            return;
+        }
+        MutableChunk(chunks_.size() - 1).pop_back();
+    }
+    void reserve(size_t count) {
+        chunks_.reserve((count + CHUNK_SIZE - 1) >> CHUNK_SHIFT);
+    }
+    //Общие куски учитываются в каждой версии, которая их держит
+    size_t GetMemoryBytes() const {
+        size_t bytes = memory::VectorBytes(chunks_);
+        for (const auto& chunk : chunks_) {
+            bytes += copy_on_write_detail::SharedBytes<Chunk>() + memory::VectorBytes(*chunk);
+        }
+        return bytes;
+    }
+
+private:
+    using Chunk = std::vector<T>;
+
+    Chunk& MutableChunk(size_t chunk) {
+        std::shared_ptr<Chunk>& data = chunks_[chunk];
+        if (!copy_on_write_detail::IsUnique(data)) {
+            auto copy = std::make_shared<Chunk>();
+            copy->reserve(CHUNK_SIZE);
+            copy->assign(data->begin(), data->end());
+            data = std::move(copy);
+        }
+        return *data;
+    }
+
+    std::vector<std::shared_ptr<Chunk>> chunks_;
+    size_t size_ = 0;
+};
+
+//Хеш-таблица из кусков, общих у копий таблицы. Кусок ключа выбирается по его хешу,
+//изменение копирует только этот кусок. Когда в кусках в среднем больше CHUNK_SIZE элементов,
+//их число удваивается: это изменение перестраивает всю таблицу, но случается редко.
+template <typename Key, typename Value, typename Hash = std::hash<Key>>
+class ChunkedHashMap {
+public:
+    static constexpr size_t CHUNK_SIZE = 256;
+
+    const Value* Find(const Key& key) const {
+        if (chunks_.empty()) {
+            return nullptr;
+        }
+        const Chunk& chunk = *chunks_[GetChunk(key)];
+        const auto it = chunk.find(key);
+        return it != chunk.end() ? &it->second : nullptr;
+    }
+    //Добавляет ключ или заменяет его значение
+    void Set(const Key& key, Value value) {
+        if (chunks_.empty()) {
+            Rehash(1);
+        }
+        auto [it, is_inserted] = MutableChunk(GetChunk(key)).insert_or_assign(key, std::move(value));
+        if (is_inserted && ++size_ > chunks_.size() * CHUNK_SIZE) {
+            Rehash(2 * chunks_.size());
+        }
+    }
+    void Erase(const Key& key) {
+        if (Find(key) != nullptr) {
+            MutableChunk(GetChunk(key)).erase(key);
+            --size_;
+        }
+    }
+    size_t size() const {
+        return size_;
+    }
+    bool empty() const {
+        return size_ == 0;
+    }
+    void reserve(size_t count) {
+        size_t chunks_count = chunks_.empty() ? 1 : chunks_.size();
+        while (chunks_count * CHUNK_SIZE < count) {
+            chunks_count *= 2;
+        }
+        if (chunks_count > chunks_.size()) {
+            Rehash(chunks_count);
+        }
+    }
+    void clear() {
+        chunks_ = {};
+        size_ = 0;
+    }
+    memory::Usage GetMemoryUsage() const {
+        memory::Usage usage{"", memory::VectorBytes(chunks_), size_};
+        size_t buckets = 0;
+        for (const auto& chunk : chunks_) {
+            usage.bytes += copy_on_write_detail::SharedBytes<Chunk>() + memory::HashTableBytes(*chunk);
+            buckets += chunk->bucket_count();
+        }
+        usage.buckets = buckets;
+        usage.load_factor = buckets == 0 ? 0.0 : static_cast<double>(size_) / buckets;
+        return usage;
+    }
+
+private:
+    using Chunk = std::unordered_map<Key, Value, Hash>;
+
+    //Старшие биты хеша: по младшим ключи раскладывает по корзинам сам кусок
+    size_t GetChunk(const Key& key) const {
+        const uint64_t hash = static_cast<uint64_t>(Hash{}(key)) * 0x9E3779B97F4A7C15ULL;
+        return chunks_.size() == 1 ? 0 : static_cast<size_t>(hash >> (64 - std::countr_zero(chunks_.size())));
+    }
+    Chunk& MutableChunk(size_t chunk) {
+        std::shared_ptr<Chunk>& data = chunks_[chunk];
+        if (!copy_on_write_detail::IsUnique(data)) {
+            data = std::make_shared<Chunk>(*data);
+        }
+        return *data;
+    }
+    void Rehash(size_t chunks_count) {
+        std::vector<std::shared_ptr<Chunk>> old_chunks(chunks_count);
+        old_chunks.swap(chunks_);
+        for (auto& chunk : chunks_) {
+            chunk = std::make_shared<Chunk>();
+        }
+        for (const auto& chunk : old_chunks) {
+            for (const auto& [key, value] : *chunk) {
+                chunks_[GetChunk(key)]->emplace(key, value);
+            }
+        }
+    }
+
+    std::vector<std::shared_ptr<Chunk>> chunks_; //Число кусков - степень двойки
+    size_t size_ = 0;
+};
+
+} //transport_catalogue
@@ -0,0 +1,23 @@
+#pragma once
+
+//Векторные ядра на AVX2 собираются всегда (через #pragma GCC target в отдельном файле),
+//а вызываются, только если их поддерживает процессор: сборка без -mavx2 тоже получает AVX2.
+//TRANSPORT_CATALOGUE_NO_SIMD отключает все векторные ядра, TRANSPORT_CATALOGUE_NO_AVX2 - только AVX2.
+#if !defined(TRANSPORT_CATALOGUE_NO_SIMD) && !defined(TRANSPORT_CATALOGUE_NO_AVX2) && defined(__x86_64__) && defined(__GNUC__)
+#define TRANSPORT_CATALOGUE_RUNTIME_AVX2
+#endif
+
+namespace cpu {
+
+#if defined(TRANSPORT_CATALOGUE_RUNTIME_AVX2)
+inline bool HasAvx2() {
+    static const bool has_avx2 = (__builtin_cpu_init(), __builtin_cpu_supports("avx2"));
+    return has_avx2;
+}
+#else
+inline bool HasAvx2() {
+    return false;
+}
+#endif
+
+} //cpu
@@ -0,0 +1,120 @@
+#include "distance_table.h"
+
+#include <algorithm>
+
+namespace transport_catalogue {
+
+namespace {
+
+template <typename Row>
+auto FindEntry(Row& row, StopId to) {
+    return std::lower_bound(row.begin(), row.end(), to, [](const auto& entry, StopId to) {
+        return entry.to < to;
+    });
+}
+
+} //namespace
+
+DistanceTable::Row& DistanceTable::MutableRow(StopId from) {
+    while (from >= rows_.size()) {
+        rows_.push_back({});
+    }
+    return rows_.Mutable(from);
+}
+
+void DistanceTable::Insert(StopId from, StopId to, int distance, bool is_explicit) {
+    Row& row = MutableRow(from);
+    const auto it = FindEntry(row, to);
+    if (it == row.end() || it->to != to) {
+        row.insert(it, {to, distance, is_explicit});
+        ++size_;
+        return;
+    }
+    if (it->is_explicit && !is_explicit) {
+        return;
+    }
+    *it = {to, distance, is_explicit};
+}
+
+void DistanceTable::Erase(StopId from, StopId to) {
+    Row& row = rows_.Mutable(from);
+    const auto it = FindEntry(row, to);
+    if (it != row.end() && it->to == to) {
+        row.erase(it);
+        --size_;
+    }
+}
+
+void DistanceTable::Set(StopId from, StopId to, int distance) {
+    Insert(from, to, distance, true);
+    Insert(to, from, distance, false);
+}
+
+std::optional<int> DistanceTable::Get(StopId from, StopId to) const {
+    if (from >= rows_.size()) {
+        return std::nullopt;
+    }
+    const Row& row = rows_[from];
+    const auto it = FindEntry(row, to);
+    if (it == row.end() || it->to != to) {
+        return std::nullopt;
+    }
+    return it->distance;
+}
+
+void DistanceTable::Reserve(size_t stops_count) {
+    rows_.reserve(stops_count);
+}
+
+void DistanceTable::EraseStop(StopId stop) {
+    if (stop >= rows_.size()) {
+        return;
+    }
+    //Изменение соседних строк может скопировать кусок этой строки, поэтому она копируется заранее
+    const Row row = rows_[stop];
+    for (const Entry& entry : row) {
+        if (entry.to != stop) {
+            Erase(entry.to, stop);
+        }
+    }
+    size_ -= row.size();
+    rows_.Mutable(stop) = {};
+}
+
+void DistanceTable::RenumberStop(StopId from, StopId to) {
+    if (from >= rows_.size()) {
+        return;
+    }
+    Row moved = rows_[from];
+    for (const Entry& entry : moved) {
+        if (entry.to != from) {
+            Row& row = rows_.Mutable(entry.to);
+            const Entry back = *FindEntry(row, from);
+            row.erase(FindEntry(row, from));
+            row.insert(FindEntry(row, to), {to, back.distance, back.is_explicit});
+        }
+    }
+    //Расстояние от остановки до себя самой переходит на новый номер с обеих сторон
+    for (Entry& entry : moved) {
+        if (entry.to == from) {
+            entry.to = to;
+        }
+    }
+    std::sort(moved.begin(), moved.end(), [](const Entry& lhs, const Entry& rhs) { return lhs.to < rhs.to; });
+    rows_.Mutable(from) = {};
+    MutableRow(to) = std::move(moved);
+}
+
+size_t DistanceTable::Size() const {
+    return size_;
+}
+
+memory::Usage DistanceTable::GetMemoryUsage() const {
+    memory::Usage usage{"", rows_.GetMemoryBytes(), size_};
+    for (const Row& row : rows_) {
+        usage.bytes += memory::VectorBytes(row);
+    }
+    return usage;
+}
+
+} //transport_catalogue
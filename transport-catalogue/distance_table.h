@@ -0,0 +1,58 @@
+#pragma once
+
+#include "copy_on_write.h"
+#include "domain.h"
+#include "memory_usage.h"
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace transport_catalogue {
+
+//Дорожные расстояния между остановками: у каждой остановки строка соседей, упорядоченная по номеру.
+//Обратное направление заполняется при добавлении, поэтому поиск - двоичный поиск в одной строке.
+//Строки лежат в ChunkedVector, поэтому копии таблицы делят их, а изменение копирует
+//только куски строк затронутых остановок.
+class DistanceTable {
+public:
+    void Set(StopId from, StopId to, int distance);
+    std::optional<int> Get(StopId from, StopId to) const;
+    size_t Size() const; //Вместе с обратными направлениями
+    void Reserve(size_t stops_count);
+    void EraseStop(StopId stop); //Удаляет расстояния от остановки и до неё
+    void RenumberStop(StopId from, StopId to); //Переносит расстояния остановки на номер to, у которого их нет
+    memory::Usage GetMemoryUsage() const;
+
+    //Вызывает action(from, to, distance) для каждого расстояния, заданного через Set
+    template <typename Action>
+    void ForEach(Action action) const;
+
+private:
+    struct Entry {
+        StopId to = 0;
+        int distance = 0;
+        bool is_explicit = false; //Расстояние задано явно, а не взято из обратного направления
+    };
+    using Row = std::vector<Entry>;
+
+    void Insert(StopId from, StopId to, int distance, bool is_explicit);
+    void Erase(StopId from, StopId to);
+    Row& MutableRow(StopId from);
+
+    ChunkedVector<Row> rows_; //По номеру остановки, откуда расстояние
+    size_t size_ = 0;
+};
+
+template <typename Action>
+void DistanceTable::ForEach(Action action) const {
+    for (StopId from = 0; from < rows_.size(); ++from) {
+        for (const Entry& entry : rows_[from]) {
+            if (entry.is_explicit) {
+                action(from, entry.to, entry.distance);
+            }
+        }
+    }
+}
+
+} //transport_catalogue
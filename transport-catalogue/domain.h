@@ -2,6 +2,10 @@
 
 #include "geo.h"
 
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <stdexcept>
 #include <vector>
 #include <string>
 #include <string_view>
@@ -9,14 +13,37 @@
 
 namespace transport_catalogue {
 
+using StopId = uint32_t; //Плотный номер остановки в порядке добавления
+using SequenceId = uint32_t; //Номер последовательности остановок в StopSequencePool
+using BusId = uint32_t; //Позиция маршрута в каталоге, меняется при удалении другого маршрута
+
 struct Stop {
-    std::string name;
+    std::string_view name; //Указывает в NameArena каталога
     Coordinates coordinates;
+    StopId id{};
+};
+
+struct BusInfo {
+    size_t stops_on_route{};
+    size_t unique_stops{};
+    double length{};
+    double curvature{};
+};
+
+//Статистика всех маршрутов по столбцам: i-е элементы столбцов относятся к маршруту names[i]
+struct BusesInfo {
+    std::vector<std::string_view> names;
+    std::vector<size_t> stops_on_route;
+    std::vector<size_t> unique_stops;
+    std::vector<double> length;
+    std::vector<double> curvature;
 };
 
 struct Bus {
-    std::string name;
-    std::vector<Stop*> stops;
+    std::string_view name;
+    SequenceId stops{}; //Только прямой ход в пуле каталога, обратный ход некольцевого маршрута не хранится
+    bool is_roundtrip = false;
+    BusInfo info; //Считается один раз при добавлении маршрута
 };
     
 struct RouteInfo {
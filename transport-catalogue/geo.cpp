@@ -1,9 +1,16 @@
 #define _USE_MATH_DEFINES
 
 #include "geo.h"
+#include "geo_kernel.h"
 
+#include <algorithm>
 #include <cmath>
 
+#if !defined(TRANSPORT_CATALOGUE_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64))
+#include <emmintrin.h>
+#define TRANSPORT_CATALOGUE_SSE2
+#endif
+
 namespace transport_catalogue {
 
 bool Coordinates::operator==(const Coordinates& other) const {
@@ -27,4 +34,136 @@ double ComputeDistance(Coordinates from, Coordinates to) {
         * 6371000;
 }
 
-} //transport_catalogue
\ No newline at end of file
+bool UnitVector::operator==(const UnitVector& other) const {
+    return x == other.x && y == other.y && z == other.z;
+}
+
+UnitVector ToUnitVector(Coordinates coordinates) {
+    using namespace std;
+    static const double dr = M_PI / 180.;
+    const double cos_lat = cos(coordinates.lat * dr);
+    return {cos_lat * cos(coordinates.lng * dr), cos_lat * sin(coordinates.lng * dr), sin(coordinates.lat * dr)};
+}
+
+double ComputeUnitDistance(const UnitVector& from, const UnitVector& to) {
+    if (from == to) {
+        return 0;
+    }
+    const double cos_angle = from.x * to.x + from.y * to.y + from.z * to.z;
+    return std::acos(std::clamp(cos_angle, -1., 1.)) * 6371000;
+}
+
+namespace {
+
+//Наборы из Batch::SIZE чисел double. Все реализации дают одинаковый результат
+//для каждого элемента, поэтому хвост массива досчитывается скалярной версией.
+struct ScalarBatch {
+    static constexpr size_t SIZE = 1;
+    struct Mask {
+        bool m;
+        Mask operator&(Mask other) const { return {m && other.m}; }
+        Mask operator|(Mask other) const { return {m || other.m}; }
+    };
+    double v;
+
+    static ScalarBatch Load(const double* data) { return {*data}; }
+    static ScalarBatch Fill(double value) { return {value}; }
+    double Sum() const { return v; }
+    friend ScalarBatch operator+(ScalarBatch a, ScalarBatch b) { return {a.v + b.v}; }
+    friend ScalarBatch operator-(ScalarBatch a, ScalarBatch b) { return {a.v - b.v}; }
+    friend ScalarBatch operator*(ScalarBatch a, ScalarBatch b) { return {a.v * b.v}; }
+    friend ScalarBatch operator-(ScalarBatch a) { return {-a.v}; }
+    friend Mask operator==(ScalarBatch a, ScalarBatch b) { return {a.v == b.v}; }
+    friend Mask operator<(ScalarBatch a, ScalarBatch b) { return {a.v < b.v}; }
+    friend ScalarBatch Abs(ScalarBatch a) { return {std::abs(a.v)}; }
+    friend ScalarBatch Sqrt(ScalarBatch a) { return {std::sqrt(a.v)}; }
+    friend ScalarBatch Select(Mask mask, ScalarBatch a, ScalarBatch b) { return mask.m ? a : b; }
+    void Store(double* data) const { *data = v; }
+};
+
+#if defined(TRANSPORT_CATALOGUE_SSE2)
+struct SimdBatch {
+    static constexpr size_t SIZE = 2;
+    struct Mask {
+        __m128d m;
+        Mask operator&(Mask other) const { return {_mm_and_pd(m, other.m)}; }
+        Mask operator|(Mask other) const { return {_mm_or_pd(m, other.m)}; }
+    };
+    __m128d v;
+
+    static SimdBatch Load(const double* data) { return {_mm_loadu_pd(data)}; }
+    static SimdBatch Fill(double value) { return {_mm_set1_pd(value)}; }
+    double Sum() const { return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v))); }
+    friend SimdBatch operator+(SimdBatch a, SimdBatch b) { return {_mm_add_pd(a.v, b.v)}; }
+    friend SimdBatch operator-(SimdBatch a, SimdBatch b) { return {_mm_sub_pd(a.v, b.v)}; }
+    friend SimdBatch operator*(SimdBatch a, SimdBatch b) { return {_mm_mul_pd(a.v, b.v)}; }
+    friend SimdBatch operator-(SimdBatch a) { return {_mm_xor_pd(a.v, _mm_set1_pd(-0.))}; }
+    friend Mask operator==(SimdBatch a, SimdBatch b) { return {_mm_cmpeq_pd(a.v, b.v)}; }
+    friend Mask operator<(SimdBatch a, SimdBatch b) { return {_mm_cmplt_pd(a.v, b.v)}; }
+    friend SimdBatch Abs(SimdBatch a) { return {_mm_andnot_pd(_mm_set1_pd(-0.), a.v)}; }
+    friend SimdBatch Sqrt(SimdBatch a) { return {_mm_sqrt_pd(a.v)}; }
+    friend SimdBatch Select(Mask mask, SimdBatch a, SimdBatch b) {
+        return {_mm_or_pd(_mm_and_pd(mask.m, a.v), _mm_andnot_pd(mask.m, b.v))};
+    }
+    void Store(double* data) const { _mm_storeu_pd(data, v); }
+};
+#else
+using SimdBatch = ScalarBatch;
+#endif
+
+} //namespace
+
+using geo_kernel::ComputeDistancesImpl;
+using geo_kernel::ComputePathDistanceImpl;
+
+//Векторная часть массива считается на AVX2, если его поддерживает процессор, иначе на SSE2
+void ComputeDistances(const double* from_lat, const double* from_lng, const double* to_lat, const double* to_lng,
+                      double* result, size_t count) {
+    size_t i = 0;
+#if defined(TRANSPORT_CATALOGUE_RUNTIME_AVX2)
+    if (cpu::HasAvx2()) {
+        i = geo_kernel::ComputeDistancesAvx2(from_lat, from_lng, to_lat, to_lng, result, count);
+    }
+    else
+#endif
+    i = ComputeDistancesImpl<SimdBatch>(from_lat, from_lng, to_lat, to_lng, result, count);
+    ComputeDistancesImpl<ScalarBatch>(from_lat + i, from_lng + i, to_lat + i, to_lng + i, result + i, count - i);
+}
+
+double ComputePathDistance(const double* lat, const double* lng, size_t count) {
+    if (count < 2) {
+        return 0.;
+    }
+    size_t i = 0;
+    double result = 0.;
+#if defined(TRANSPORT_CATALOGUE_RUNTIME_AVX2)
+    if (cpu::HasAvx2()) {
+        result = geo_kernel::ComputePathDistanceAvx2(lat, lng, count, i);
+    }
+    else
+#endif
+    result = ComputePathDistanceImpl<SimdBatch>(lat, lng, count, i);
+    size_t tail = 0;
+    result += ComputePathDistanceImpl<ScalarBatch>(lat + i, lng + i, count - i, tail);
+    return result;
+}
+
+double ComputePathDistance(const double* x, const double* y, const double* z, size_t count) {
+    if (count < 2) {
+        return 0.;
+    }
+    size_t i = 0;
+    double result = 0.;
+#if defined(TRANSPORT_CATALOGUE_RUNTIME_AVX2)
+    if (cpu::HasAvx2()) {
+        result = geo_kernel::ComputePathDistanceAvx2(x, y, z, count, i);
+    }
+    else
+#endif
+    result = ComputePathDistanceImpl<SimdBatch>(x, y, z, count, i);
+    size_t tail = 0;
+    result += ComputePathDistanceImpl<ScalarBatch>(x + i, y + i, z + i, count - i, tail);
+    return result;
+}
+
+} //transport_catalogue
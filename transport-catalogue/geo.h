@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cmath>
+#include <cstddef>
 
 namespace transport_catalogue {
 
@@ -14,4 +15,35 @@ struct Coordinates {
 
 double ComputeDistance(Coordinates from, Coordinates to);
 
+//Точка на единичной сфере. Скалярное произведение двух векторов - косинус угла между точками,
+//поэтому для известных заранее точек расстояние считается без sin и cos.
+struct UnitVector {
+    double x;
+    double y;
+    double z;
+    bool operator==(const UnitVector& other) const;
+};
+
+UnitVector ToUnitVector(Coordinates coordinates);
+
+double ComputeUnitDistance(const UnitVector& from, const UnitVector& to);
+
+//Пакетные версии ComputeDistance. Координаты передаются отдельными массивами широт и долгот.
+//AVX2 выбирается при запуске, если его поддерживает процессор (cpu::HasAvx2), иначе SSE2,
+//а без них - скалярный код с тем же алгоритмом. Макрос TRANSPORT_CATALOGUE_NO_AVX2 отключает
+//AVX2, TRANSPORT_CATALOGUE_NO_SIMD - все векторные версии.
+//sin, cos и acos считаются полиномами с погрешностью в несколько ulp. Итоговая ошибка
+//такая же, как у ComputeDistance: её ограничивает сама формула через acos, абсолютная
+//погрешность не больше 0.15 м, для расстояний больше 1 км относительная - не больше 2e-8.
+
+//result[i] - расстояние от (from_lat[i], from_lng[i]) до (to_lat[i], to_lng[i])
+void ComputeDistances(const double* from_lat, const double* from_lng, const double* to_lat, const double* to_lng,
+                      double* result, size_t count);
+
+//Длина ломаной, проходящей через count точек (lat[i], lng[i])
+double ComputePathDistance(const double* lat, const double* lng, size_t count);
+
+//Длина ломаной по точкам, заданным единичными векторами (x[i], y[i], z[i])
+double ComputePathDistance(const double* x, const double* y, const double* z, size_t count);
+
 }
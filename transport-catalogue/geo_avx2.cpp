@@ -0,0 +1,67 @@
+#define _USE_MATH_DEFINES
+
+//Ядро geo_kernel.h, собранное с AVX2. geo.cpp вызывает его, только если процессор поддерживает AVX2
+#include "cpu_features.h"
+
+#if defined(TRANSPORT_CATALOGUE_RUNTIME_AVX2)
+
+//Стандартные заголовки подключаются до #pragma, чтобы их inline-функции не получили инструкции AVX2
+#include <cmath>
+#include <cstddef>
+#include <immintrin.h>
+
+#pragma GCC target("avx2")
+
+#include "geo_kernel.h"
+
+namespace transport_catalogue::geo_kernel {
+
+namespace {
+
+struct Avx2Batch {
+    static constexpr size_t SIZE = 4;
+    struct Mask {
+        __m256d m;
+        Mask operator&(Mask other) const { return {_mm256_and_pd(m, other.m)}; }
+        Mask operator|(Mask other) const { return {_mm256_or_pd(m, other.m)}; }
+    };
+    __m256d v;
+
+    static Avx2Batch Load(const double* data) { return {_mm256_loadu_pd(data)}; }
+    static Avx2Batch Fill(double value) { return {_mm256_set1_pd(value)}; }
+    double Sum() const {
+        const __m128d half = _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+        return _mm_cvtsd_f64(_mm_add_sd(half, _mm_unpackhi_pd(half, half)));
+    }
+    void Store(double* data) const { _mm256_storeu_pd(data, v); }
+};
+
+//Операции определены вне класса: на дружественные функции внутри класса #pragma GCC target не действует
+inline Avx2Batch operator+(Avx2Batch a, Avx2Batch b) { return {_mm256_add_pd(a.v, b.v)}; }
+inline Avx2Batch operator-(Avx2Batch a, Avx2Batch b) { return {_mm256_sub_pd(a.v, b.v)}; }
+inline Avx2Batch operator*(Avx2Batch a, Avx2Batch b) { return {_mm256_mul_pd(a.v, b.v)}; }
+inline Avx2Batch operator-(Avx2Batch a) { return {_mm256_xor_pd(a.v, _mm256_set1_pd(-0.))}; }
+inline Avx2Batch::Mask operator==(Avx2Batch a, Avx2Batch b) { return {_mm256_cmp_pd(a.v, b.v, _CMP_EQ_OQ)}; }
+inline Avx2Batch::Mask operator<(Avx2Batch a, Avx2Batch b) { return {_mm256_cmp_pd(a.v, b.v, _CMP_LT_OQ)}; }
+inline Avx2Batch Abs(Avx2Batch a) { return {_mm256_andnot_pd(_mm256_set1_pd(-0.), a.v)}; }
+inline Avx2Batch Sqrt(Avx2Batch a) { return {_mm256_sqrt_pd(a.v)}; }
+inline Avx2Batch Select(Avx2Batch::Mask mask, Avx2Batch a, Avx2Batch b) { return {_mm256_blendv_pd(b.v, a.v, mask.m)}; }
+
+} //namespace
+
+size_t ComputeDistancesAvx2(const double* from_lat, const double* from_lng, const double* to_lat, const double* to_lng,
+                            double* result, size_t count) {
+    return ComputeDistancesImpl<Avx2Batch>(from_lat, from_lng, to_lat, to_lng, result, count);
+}
+
+double ComputePathDistanceAvx2(const double* lat, const double* lng, size_t count, size_t& processed) {
+    return ComputePathDistanceImpl<Avx2Batch>(lat, lng, count, processed);
+}
+
+double ComputePathDistanceAvx2(const double* x, const double* y, const double* z, size_t count, size_t& processed) {
+    return ComputePathDistanceImpl<Avx2Batch>(x, y, z, count, processed);
+}
+
+} //transport_catalogue::geo_kernel
+
+#endif
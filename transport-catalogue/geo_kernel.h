@@ -0,0 +1,156 @@
+#pragma once
+
+//Обобщённое ядро пакетного расчёта расстояний для geo.cpp и geo_avx2.cpp.
+//Batch - набор из Batch::SIZE чисел double с арифметикой, сравнениями, Abs, Sqrt и Select.
+//Файл, который собирает ядро с AVX2, подключает этот заголовок после #pragma GCC target.
+
+#include "cpu_features.h"
+
+#include <cmath>
+#include <cstddef>
+
+namespace transport_catalogue::geo_kernel {
+
+template <typename Batch, size_t N>
+Batch Polynomial(Batch x, const double (&coefficients)[N]) {
+    Batch result = Batch::Fill(coefficients[0]);
+    for (size_t i = 1; i < N; ++i) {
+        result = result * x + Batch::Fill(coefficients[i]);
+    }
+    return result;
+}
+
+//Округление до ближайшего целого для |x| < 2^51. Не работает с -ffast-math.
+template <typename Batch>
+Batch Round(Batch x) {
+    const Batch magic = Batch::Fill(6755399441055744.0);
+    return (x + magic) - magic;
+}
+
+//sin и cos для |x| <= 2pi. Аргумент приводится к [-pi/4, pi/4] вычитанием k * pi/2,
+//где pi/2 разбито на три части (как в fdlibm), дальше - ряды Тейлора до x^17 и x^16,
+//погрешность которых меньше 1e-19. Итоговая ошибка - несколько ulp.
+template <typename Batch>
+void SinCos(Batch x, Batch& sin_x, Batch& cos_x) {
+    static constexpr double SIN_COEFFICIENTS[] = {
+        2.8114572543455206e-15, -7.6471637318198164e-13, 1.6059043836821613e-10, -2.505210838544172e-08,
+        2.7557319223985893e-06, -0.00019841269841269841, 0.0083333333333333332, -0.16666666666666666};
+    static constexpr double COS_COEFFICIENTS[] = {
+        4.7794773323873853e-14, -1.1470745597729725e-11, 2.08767569878681e-09, -2.7557319223985888e-07,
+        2.4801587301587302e-05, -0.0013888888888888889, 0.041666666666666664};
+
+    const Batch quadrant = Round(x * Batch::Fill(M_2_PI));
+    const Batch r = ((x - quadrant * Batch::Fill(1.57079632673412561417e+00))
+                     - quadrant * Batch::Fill(6.07710050630396597660e-11))
+                    - quadrant * Batch::Fill(2.02226624879595063154e-21);
+    const Batch z = r * r;
+    const Batch sin_r = r + r * z * Polynomial(z, SIN_COEFFICIENTS);
+    const Batch cos_r = Batch::Fill(1.) - Batch::Fill(0.5) * z + z * z * Polynomial(z, COS_COEFFICIENTS);
+
+    //Номер четверти по модулю 4: quadrant - 4 * floor(quadrant / 4)
+    const Batch quarter = quadrant - Batch::Fill(4.) * Round(quadrant * Batch::Fill(0.25) - Batch::Fill(0.375));
+    const auto is_odd = (quarter == Batch::Fill(1.)) | (quarter == Batch::Fill(3.));
+    const auto sin_negative = Batch::Fill(1.5) < quarter;
+    const auto cos_negative = (quarter == Batch::Fill(1.)) | (quarter == Batch::Fill(2.));
+    const Batch sin_abs = Select(is_odd, cos_r, sin_r);
+    const Batch cos_abs = Select(is_odd, sin_r, cos_r);
+    sin_x = Select(sin_negative, -sin_abs, sin_abs);
+    cos_x = Select(cos_negative, -cos_abs, cos_abs);
+}
+
+//asin для 0 <= x <= 0.5: ряд Тейлора до x^43, остаток меньше 1e-16 * asin(x)
+template <typename Batch>
+Batch AsinSmall(Batch x) {
+    static constexpr double COEFFICIENTS[] = {
+        0.0028461784011089421, 0.0030578216492580306, 0.0032970595034734849, 0.0035692053938259347,
+        0.0038809645588376691, 0.0042409070936793632, 0.0046601434869150962, 0.0051533096823199046,
+        0.0057400376708419236, 0.0064472103118896487, 0.0073125258735988454, 0.0083903358096168151,
+        0.0097616095291940784, 0.011551800896139705, 0.013964843750000001, 0.017352764423076924,
+        0.022372159090909092, 0.030381944444444444, 0.044642857142857144, 0.074999999999999997,
+        0.16666666666666666};
+    const Batch z = x * x;
+    return x + x * z * Polynomial(z, COEFFICIENTS);
+}
+
+//acos для -1 <= x <= 1. При |x| > 0.5 используется acos(x) = 2 * asin(sqrt((1 - x) / 2)),
+//где 1 - |x| считается точно, поэтому малые углы не теряют точность.
+template <typename Batch>
+Batch Acos(Batch x) {
+    const Batch abs_x = Abs(x);
+    const auto is_big = Batch::Fill(0.5) < abs_x;
+    const Batch asin_arg = Select(is_big, Sqrt((Batch::Fill(1.) - abs_x) * Batch::Fill(0.5)), abs_x);
+    const Batch asin_value = AsinSmall(asin_arg);
+    const auto is_negative = x < Batch::Fill(0.);
+    const Batch small_result = Batch::Fill(M_PI_2) - Select(is_negative, -asin_value, asin_value);
+    const Batch big_result = Select(is_negative, Batch::Fill(M_PI) - (asin_value + asin_value), asin_value + asin_value);
+    return Select(is_big, big_result, small_result);
+}
+
+//Тот же расчёт, что в ComputeDistance
+template <typename Batch>
+Batch DistanceBatch(Batch from_lat, Batch from_lng, Batch to_lat, Batch to_lng) {
+    const Batch dr = Batch::Fill(M_PI / 180.);
+    Batch sin_from, cos_from, sin_to, cos_to, sin_lng, cos_lng;
+    SinCos(from_lat * dr, sin_from, cos_from);
+    SinCos(to_lat * dr, sin_to, cos_to);
+    SinCos(Abs(from_lng - to_lng) * dr, sin_lng, cos_lng);
+    Batch cos_angle = sin_from * sin_to + cos_from * cos_to * cos_lng;
+    //Ошибки округления могут вывести косинус за пределы [-1, 1]
+    cos_angle = Select(Batch::Fill(1.) < cos_angle, Batch::Fill(1.), cos_angle);
+    cos_angle = Select(cos_angle < Batch::Fill(-1.), Batch::Fill(-1.), cos_angle);
+    const Batch distance = Acos(cos_angle) * Batch::Fill(6371000.);
+    return Select((from_lat == to_lat) & (from_lng == to_lng), Batch::Fill(0.), distance);
+}
+
+template <typename Batch>
+Batch DistanceBatch(Batch from_x, Batch from_y, Batch from_z, Batch to_x, Batch to_y, Batch to_z) {
+    Batch cos_angle = from_x * to_x + from_y * to_y + from_z * to_z;
+    cos_angle = Select(Batch::Fill(1.) < cos_angle, Batch::Fill(1.), cos_angle);
+    cos_angle = Select(cos_angle < Batch::Fill(-1.), Batch::Fill(-1.), cos_angle);
+    const Batch distance = Acos(cos_angle) * Batch::Fill(6371000.);
+    return Select((from_x == to_x) & (from_y == to_y) & (from_z == to_z), Batch::Fill(0.), distance);
+}
+
+template <typename Batch>
+size_t ComputeDistancesImpl(const double* from_lat, const double* from_lng, const double* to_lat, const double* to_lng,
+                            double* result, size_t count) {
+    size_t i = 0;
+    for (; i + Batch::SIZE <= count; i += Batch::SIZE) {
+        DistanceBatch(Batch::Load(from_lat + i), Batch::Load(from_lng + i), Batch::Load(to_lat + i), Batch::Load(to_lng + i))
+            .Store(result + i);
+    }
+    return i;
+}
+
+template <typename Batch>
+double ComputePathDistanceImpl(const double* lat, const double* lng, size_t count, size_t& processed) {
+    Batch sum = Batch::Fill(0.);
+    size_t i = 0;
+    for (; i + Batch::SIZE < count; i += Batch::SIZE) {
+        sum = sum + DistanceBatch(Batch::Load(lat + i), Batch::Load(lng + i), Batch::Load(lat + i + 1), Batch::Load(lng + i + 1));
+    }
+    processed = i;
+    return sum.Sum();
+}
+
+template <typename Batch>
+double ComputePathDistanceImpl(const double* x, const double* y, const double* z, size_t count, size_t& processed) {
+    Batch sum = Batch::Fill(0.);
+    size_t i = 0;
+    for (; i + Batch::SIZE < count; i += Batch::SIZE) {
+        sum = sum + DistanceBatch(Batch::Load(x + i), Batch::Load(y + i), Batch::Load(z + i),
+                                  Batch::Load(x + i + 1), Batch::Load(y + i + 1), Batch::Load(z + i + 1));
+    }
+    processed = i;
+    return sum.Sum();
+}
+
+#if defined(TRANSPORT_CATALOGUE_RUNTIME_AVX2)
+//Ядро на AVX2 из geo_avx2.cpp, вызывать только при cpu::HasAvx2()
+size_t ComputeDistancesAvx2(const double* from_lat, const double* from_lng, const double* to_lat, const double* to_lng,
+                            double* result, size_t count);
+double ComputePathDistanceAvx2(const double* lat, const double* lng, size_t count, size_t& processed);
+double ComputePathDistanceAvx2(const double* x, const double* y, const double* z, size_t count, size_t& processed);
+#endif
+
+} //transport_catalogue::geo_kernel
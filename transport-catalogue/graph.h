@@ -4,7 +4,9 @@
 #include <vector>
 #include <iostream>
 #include <string_view>
+#include <unordered_map>
 
+#include "memory_usage.h"
 #include "ranges.h"
 
 namespace graph {
@@ -39,6 +41,7 @@ public:
     size_t GetEdgeCount() const;
     const Edge<Weight>& GetEdge(EdgeId edge_id) const;
     IncidentEdgesRange GetIncidentEdges(VertexId vertex) const;
+    memory::Report GetMemoryUsage() const;
 
     std::unordered_map<std::string_view, int> stops_id;
     std::unordered_map<int, std::string_view> stops_name;
@@ -82,4 +85,18 @@ typename DirectedWeightedGraph<Weight>::IncidentEdgesRange
 DirectedWeightedGraph<Weight>::GetIncidentEdges(VertexId vertex) const {
     return ranges::AsRange(incidence_lists_.at(vertex));
 }
+template <typename Weight>
+memory::Report DirectedWeightedGraph<Weight>::GetMemoryUsage() const {
+    memory::Usage incidence_lists = memory::VectorUsage("graph.incidence_lists", incidence_lists_);
+    for (const IncidenceList& list : incidence_lists_) {
+        incidence_lists.bytes += memory::VectorBytes(list);
+    }
+    return {
+        memory::VectorUsage("graph.edges", edges_),
+        std::move(incidence_lists),
+        memory::HashTableUsage("graph.edges_info", edges_info),
+        memory::HashTableUsage("graph.stops_id", stops_id),
+        memory::HashTableUsage("graph.stops_name", stops_name)
+    };
+}
 }  // namespace graph
\ No newline at end of file
@@ -1,4 +1,22 @@
 #include "json.h"
+#include "json_scanner.h"
+#include "memory_usage.h"
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cstring>
+#include <deque>
+#include <limits>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <unordered_map>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 using namespace std;
 
@@ -6,195 +24,166 @@ namespace json {
 
 namespace {
 
-Node LoadNode(istream& input);
-
-void CheckInput(istream& input) {
-    if (!input) {
-        throw ParsingError("Failed to read number from stream"s);
-    }
-}
-    
-char CharNoSpace(istream& input) {
-    char c;
-    while (input >> c) {
-        CheckInput(input);
-        if ((c != ' ') && (c != '\r') && (c != '\n') && (c != '\t')) {
-            break;
-        } 
+// Второй проход разбора: строит узлы, переходя по позициям значимых символов
+// из StructuralScanner, поэтому пробелы и содержимое строк заново не просматриваются.
+// Контейнеры и строки размещаются в resource. При borrow_strings строковые значения
+// без escape-последовательностей не копируются, а указывают в text.
+class Parser {
+public:
+    Parser(string_view text, pmr::memory_resource* resource, bool borrow_strings)
+        : text_(text), scanner_(text), resource_(resource), borrow_strings_(borrow_strings) {
     }
-    return c;
-}
-    
-Node LoadArray(istream& input) {
-    Array result;
-    for (char c; (input >> c) && (input) && c != ']';) {
-        CheckInput(input);
-        if (c != ',') {
-            input.putback(c);
+
+    Node LoadNode() {
+        const size_t position = NextToken();
+        switch (text_[position]) {
+            case '[':
+                return LoadArray();
+            case '{':
+                return LoadDict();
+            case '"':
+                return LoadStringNode(position);
+            case 'n':
+                LoadLiteral(position, "null"sv);
+                return Node();
+            case 't':
+                LoadLiteral(position, "true"sv);
+                return Node(true);
+            case 'f':
+                LoadLiteral(position, "false"sv);
+                return Node(false);
+            default:
+                return LoadNumber(position);
         }
-        result.push_back(LoadNode(input));
     }
-    CheckInput(input);
-    return Node(move(result));
-}
 
-Node LoadNull(istream& input) {
-    char c;
-    string str{""};
-    for (int i = 0; i < 3; ++i) {
-        c = CharNoSpace(input);
-        CheckInput(input);
-        str += c;
-    }
-    if (str == "ull") {
-        c = CharNoSpace(input);
-        if (!input) {
-            return Node();
-        }
-        if ((c != ']') && (c != '}') && (c != ',')) {
-            throw ParsingError("Failed to read number from stream"s);
+private:
+    // Позиция следующего значимого символа; конец ввода посреди документа - ошибка
+    size_t NextToken() {
+        const size_t position = scanner_.Next();
+        if (position == StructuralScanner::END) {
+            throw ParsingError("Unexpected end of input"s);
         }
-        input.putback(c);
-        return Node();
+        return position;
     }
-    throw ParsingError("Wrong name!"s);
-}
 
-bool LoadBool(istream& input) {
-    char c;
-    string str{""};
-    for (int i = 0; i < 4; ++i) {
-        c = CharNoSpace(input);
-        CheckInput(input);
-        str += c;
-    }
-    if (str == "true") {
-        c = CharNoSpace(input);
-        if (!input) {
-            return true;
+    char PeekToken() {
+        const size_t position = scanner_.Peek();
+        if (position == StructuralScanner::END) {
+            throw ParsingError("Unexpected end of input"s);
         }
-        if ((c != ']') && (c != '}') && (c != ',')) {
-            throw ParsingError("Failed to read number from stream"s);
-        }
-        input.putback(c);
-        return true;
-    }
-    else if (str == "fals") {
-        c = CharNoSpace(input);
-        CheckInput(input);
-        str += c;
-    }
-    else {
-        throw ParsingError("Wrong name!"s);
+        return text_[position];
     }
-    if (str == "false") {
-        c = CharNoSpace(input);
-        if (!input) {
-            return false;
+
+    // Элементы копятся в общем стеке, а массив создаётся сразу нужного размера:
+    // при росте вектора в арене оставались бы брошенные буферы
+    Node LoadArray() {
+        const size_t begin = items_.size();
+        if (PeekToken() == ']') {
+            scanner_.Next();
         }
-        if ((c != ']') && (c != '}') && (c != ',')) {
-            throw ParsingError("Failed to read number from stream"s);
+        else {
+            while (true) {
+                items_.push_back(LoadNode());
+                const char c = text_[NextToken()];
+                if (c == ']') {
+                    break;
+                }
+                if (c != ',') {
+                    throw ParsingError("Expected , or ] in array"s);
+                }
+            }
         }
-        input.putback(c);
-        return false;
+        Array result(make_move_iterator(items_.begin() + begin), make_move_iterator(items_.end()), resource_);
+        items_.erase(items_.begin() + begin, items_.end());
+        return Node(move(result));
     }
-    throw ParsingError("Wrong name!"s);
-}
-    
-using Number = std::variant<int, double>;
 
-Number LoadNumber(std::istream& input) {
-    using namespace std::literals;
-
-    std::string parsed_num;
-    // Считывает в parsed_num очередной символ из input
-    auto read_char = [&parsed_num, &input] {
-        parsed_num += static_cast<char>(input.get());
-        CheckInput(input);
-    };
-
-    // Считывает одну или более цифр в parsed_num из input
-    auto read_digits = [&input, read_char] {
-        if (!std::isdigit(input.peek())) {
-            throw ParsingError("A digit is expected"s);
+    // Пары копятся в общем стеке так же, как элементы массивов
+    Node LoadDict() {
+        const size_t begin = fields_.size();
+        if (PeekToken() == '}') {
+            scanner_.Next();
         }
-        while (std::isdigit(input.peek())) {
-            read_char();
+        else {
+            while (true) {
+                const size_t key_position = NextToken();
+                if (text_[key_position] != '"') {
+                    throw ParsingError("Expected string key in dict"s);
+                }
+                Key key = LoadKey(key_position);
+                if (text_[NextToken()] != ':') {
+                    throw ParsingError("Expected : after key "s + string(key.AsString()));
+                }
+                fields_.emplace_back(move(key), LoadNode());
+                const char c = text_[NextToken()];
+                if (c == '}') {
+                    break;
+                }
+                if (c != ',') {
+                    throw ParsingError("Expected , or } in dict"s);
+                }
+            }
         }
-    };
-
-    if (input.peek() == '-') {
-        read_char();
+        Dict::Items items(make_move_iterator(fields_.begin() + begin), make_move_iterator(fields_.end()), resource_);
+        fields_.erase(fields_.begin() + begin, fields_.end());
+        return Node(Dict(move(items)));
     }
-    // Парсим целую часть числа
-    if (input.peek() == '0') {
-        read_char();
-        // После 0 в JSON не могут идти другие цифры
-    } else {
-        read_digits();
+
+    // Символы строки между открывающей кавычкой в begin и закрывающей - следующей позицией сканера
+    string_view GetStringChars(size_t begin) {
+        const size_t end = scanner_.Next();
+        if (end == StructuralScanner::END) {
+            throw ParsingError("String parsing error"s);
+        }
+        return text_.substr(begin + 1, end - begin - 1);
     }
 
-    bool is_int = true;
-    // Парсим дробную часть числа
-    if (input.peek() == '.') {
-        read_char();
-        read_digits();
-        is_int = false;
+    Node LoadStringNode(size_t begin) {
+        const string_view chars = GetStringChars(begin);
+        if (chars.find('\\') != string_view::npos) {
+            return Node(BorrowedString{CopyToArena(Unescape(chars))});
+        }
+        return Node(BorrowedString{borrow_strings_ ? chars : CopyToArena(chars)});
     }
 
-    // Парсим экспоненциальную часть числа
-    if (int ch = input.peek(); ch == 'e' || ch == 'E') {
-        read_char();
-        if (ch = input.peek(); ch == '+' || ch == '-') {
-            read_char();
+    // Ключ схемы берётся из общей таблицы, остальные имена лежат там же, где строковые значения
+    Key LoadKey(size_t begin) {
+        const string_view chars = GetStringChars(begin);
+        const bool is_escaped = chars.find('\\') != string_view::npos;
+        const string_view name = is_escaped ? Unescape(chars) : chars;
+        if (optional<Key> key = Key::FindInterned(name)) {
+            return move(*key);
         }
-        read_digits();
-        is_int = false;
+        return Key::Borrow(borrow_strings_ && !is_escaped ? name : CopyToArena(name));
     }
 
-    try {
-        if (is_int) {
-            // Сначала пробуем преобразовать строку в int
-            try {
-                return std::stoi(parsed_num);
-            } catch (...) {
-                // В случае неудачи, например, при переполнении,
-                // код ниже попробует преобразовать строку в double
-            }
+    string_view CopyToArena(string_view chars) {
+        if (chars.empty()) {
+            return {};
         }
-        return std::stod(parsed_num);
-    } catch (...) {
-        throw ParsingError("Failed to convert "s + parsed_num + " to number"s);
+        char* data = static_cast<char*>(resource_->allocate(chars.size(), 1));
+        memcpy(data, chars.data(), chars.size());
+        return {data, chars.size()};
     }
-}
 
-// Считывает содержимое строкового литерала JSON-документа
-// Функцию следует использовать после считывания открывающего символа ":
-std::string LoadString(std::istream& input) {
-    using namespace std::literals;
-    
-    auto it = std::istreambuf_iterator<char>(input);
-    auto end = std::istreambuf_iterator<char>();
-    std::string s;
-    while (true) {
-        if (it == end) {
-            // Поток закончился до того, как встретили закрывающую кавычку?
-            throw ParsingError("String parsing error");
-        }
-        const char ch = *it;
-        if (ch == '"') {
-            // Встретили закрывающую кавычку
-            ++it;
-            break;
-        } else if (ch == '\\') {
-            // Встретили начало escape-последовательности
-            ++it;
-            if (it == end) {
-                // Поток завершился сразу после символа обратной косой черты
-                throw ParsingError("String parsing error");
+    // Раскодированная строка действительна до следующего вызова.
+    // Кавычки и переводы строк внутри chars уже проверил сканер
+    string_view Unescape(string_view chars) {
+        string& s = unescaped_;
+        s.clear();
+        for (size_t i = 0; i < chars.size(); ++i) {
+            const size_t backslash = chars.find('\\', i);
+            if (backslash == string_view::npos) {
+                s.append(chars.substr(i));
+                break;
+            }
+            s.append(chars.substr(i, backslash - i));
+            i = backslash + 1;
+            if (i == chars.size()) {
+                throw ParsingError("String parsing error"s);
             }
-            const char escaped_char = *(it);
-            // Обрабатываем одну из последовательностей: \\, \n, \t, \r, \"
+            const char escaped_char = chars[i];
             switch (escaped_char) {
                 case 'n':
                     s.push_back('\n');
@@ -212,68 +201,460 @@ std::string LoadString(std::istream& input) {
                     s.push_back('\\');
                     break;
                 default:
-                    // Встретили неизвестную escape-последовательность
                     throw ParsingError("Unrecognized escape sequence \\"s + escaped_char);
             }
-        } else if (ch == '\n' || ch == '\r') {
-            // Строковый литерал внутри- JSON не может прерываться символами \r или \n
-            throw ParsingError("Unexpected end of line"s);
-        } else {
-            // Просто считываем очередной символ и помещаем его в результирующую строку
-            s.push_back(ch);
         }
-        ++it;
+        return s;
     }
 
-    return s;
-}    
-    
-Node LoadDict(istream& input) {
-    Dict result;
-
-    for (char c; (input >> c) && (input) && (c != '}');) {
-        CheckInput(input);
-        if (c == ',') {
-            c = CharNoSpace(input);
-        }
-
-        string key = LoadString(input);
-        c = CharNoSpace(input);
-        result.insert({move(key), LoadNode(input)});
-    }
-    CheckInput(input);
-    return Node(move(result));
-}
-
-Node LoadNode(istream& input) {
-    char c;
-    c = CharNoSpace(input);
-    if (c == '[') {
-        return LoadArray(input);
-    } else if (c == '{') {
-        return LoadDict(input);
-    } else if (c == '"') {
-        return Node(LoadString(input));
-    } else if (c == 'n') {
-        return Node(LoadNull(input));
-    } else if ((c == 't') || (c == 'f')) {
-        input.putback(c);
-        return Node(LoadBool(input));
-    } else {
-        input.putback(c);
-        auto tmp = LoadNumber(input);
-        const auto* root1 = get_if<int>(&tmp);
-        if (root1) {
-            return Node(*root1);
+    // Число или литерал продолжается до пробела, значимого символа или конца текста
+    bool IsValueEnd(size_t position) const {
+        if (position == text_.size()) {
+            return true;
+        }
+        switch (text_[position]) {
+            case ' ':
+            case '\t':
+            case '\n':
+            case '\r':
+            case ',':
+            case ':':
+            case '[':
+            case ']':
+            case '{':
+            case '}':
+            case '"':
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    void LoadLiteral(size_t position, string_view literal) {
+        if (text_.substr(position, literal.size()) != literal || !IsValueEnd(position + literal.size())) {
+            throw ParsingError("Wrong name!"s);
+        }
+    }
+
+    size_t SkipDigits(size_t position) const {
+        if (position == text_.size() || !isdigit(static_cast<unsigned char>(text_[position]))) {
+            throw ParsingError("A digit is expected"s);
+        }
+        while (position != text_.size() && isdigit(static_cast<unsigned char>(text_[position]))) {
+            ++position;
+        }
+        return position;
+    }
+
+    // Сначала проверяется грамматика числа, затем текст целиком преобразуется без копирования
+    Node LoadNumber(size_t begin) {
+        size_t position = begin;
+        if (text_[position] == '-') {
+            ++position;
+        }
+        // После 0 в JSON не могут идти другие цифры
+        if (position != text_.size() && text_[position] == '0') {
+            ++position;
         }
         else {
-            return Node(*(get_if<double>(&tmp)));
+            position = SkipDigits(position);
+        }
+        bool is_int = true;
+        if (position != text_.size() && text_[position] == '.') {
+            position = SkipDigits(position + 1);
+            is_int = false;
+        }
+        if (position != text_.size() && (text_[position] == 'e' || text_[position] == 'E')) {
+            ++position;
+            if (position != text_.size() && (text_[position] == '+' || text_[position] == '-')) {
+                ++position;
+            }
+            position = SkipDigits(position);
+            is_int = false;
+        }
+        const char* first = text_.data() + begin;
+        const char* last = text_.data() + position;
+        if (!IsValueEnd(position)) {
+            throw ParsingError("Failed to convert "s + string(first, last + 1) + " to number"s);
+        }
+        if (is_int) {
+            int value;
+            if (auto [end, error] = from_chars(first, last, value); error == errc{} && end == last) {
+                return Node(value);
+            }
+            // При переполнении int число читается как double
+        }
+        double value;
+        if (auto [end, error] = from_chars(first, last, value); error != errc{} || end != last) {
+            throw ParsingError("Failed to convert "s + string(first, last) + " to number"s);
+        }
+        return Node(value);
+    }
+
+    string_view text_;
+    StructuralScanner scanner_;
+    pmr::memory_resource* resource_;
+    bool borrow_strings_;
+    vector<Node> items_; // Элементы недостроенных массивов
+    vector<Dict::value_type> fields_; // Пары недостроенных словарей
+    string unescaped_;
+};
+
+// Куча, которая считает взятые у неё байты. Арена берёт блоки в одном потоке: при разборе или сборке документа
+class CountingResource final : public pmr::memory_resource {
+public:
+    size_t GetBytes() const {
+        return bytes_;
+    }
+
+private:
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        void* data = pmr::new_delete_resource()->allocate(bytes, alignment);
+        bytes_ += bytes;
+        return data;
+    }
+    void do_deallocate(void* data, size_t bytes, size_t alignment) override {
+        pmr::new_delete_resource()->deallocate(data, bytes, alignment);
+        bytes_ -= bytes;
+    }
+    bool do_is_equal(const pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+
+    size_t bytes_ = 0;
+};
+
+// Арена разобранного документа. Узлы в ней не разрушаются: вся память возвращается сразу
+struct DocumentArena {
+    DocumentArena(size_t initial_size, shared_ptr<const void> source)
+        : source(move(source)), resource(initial_size, &upstream) {
+    }
+
+    shared_ptr<const void> source; // Буфер, на который ссылаются заимствованные строки
+    CountingResource upstream;
+    pmr::monotonic_buffer_resource resource;
+};
+
+// Узлов и строк в документе примерно столько же байтов, сколько в тексте
+Document LoadToArena(string_view text, shared_ptr<const void> source) {
+    constexpr size_t MIN_ARENA_SIZE = 4096;
+    const bool borrow_strings = source != nullptr;
+    auto arena = make_shared<DocumentArena>(max(text.size(), MIN_ARENA_SIZE), move(source));
+    Node root = Parser(text, &arena->resource, borrow_strings).LoadNode();
+    Node* arena_root = new (arena->resource.allocate(sizeof(Node), alignof(Node))) Node(move(root));
+    return Document{shared_ptr<const Node>(move(arena), arena_root)};
+}
+
+// Файл только для чтения, отображённый в память
+class MappedFile {
+public:
+    explicit MappedFile(const string& path) {
+        const int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw runtime_error("Cannot open "s + path);
         }
+        struct stat file_stat{};
+        if (fstat(fd, &file_stat) != 0) {
+            close(fd);
+            throw runtime_error("Cannot read "s + path);
+        }
+        size_ = static_cast<size_t>(file_stat.st_size);
+        if (size_ == 0) {
+            close(fd);
+            return;
+        }
+        void* data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (data == MAP_FAILED) {
+            throw runtime_error("Cannot map "s + path);
+        }
+        // Разбор идёт от начала к концу, ядру стоит читать страницы наперёд
+        madvise(data, size_, MADV_SEQUENTIAL);
+        data_ = static_cast<const char*>(data);
+    }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile() {
+        if (data_ != nullptr) {
+            munmap(const_cast<char*>(data_), size_);
+        }
+    }
+
+    string_view GetData() const {
+        return {data_, size_};
     }
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+// Поток читается большими кусками в одну строку
+string ReadAll(istream& input) {
+    constexpr size_t CHUNK_SIZE = 1 << 20;
+    string text;
+    size_t size = 0;
+    do {
+        text.resize(size + CHUNK_SIZE);
+        input.read(text.data() + size, CHUNK_SIZE);
+        size += static_cast<size_t>(input.gcount());
+    } while (input);
+    text.resize(size);
+    return text;
+}
+
+// Имена ключей схемы. Добавляются под исключительной блокировкой,
+// а читаются под разделяемой: документы разбираются в нескольких потоках
+class KeyTable {
+public:
+    const string* Find(string_view name) {
+        if ((filter_.load(memory_order_acquire) & FilterBit(name)) == 0) {
+            return nullptr;
+        }
+        shared_lock lock(mutex_);
+        const auto it = index_.find(name);
+        return it != index_.end() ? it->second : nullptr;
+    }
+
+    const string* Intern(string_view name) {
+        {
+            shared_lock lock(mutex_);
+            if (auto it = index_.find(name); it != index_.end()) {
+                return it->second;
+            }
+        }
+        unique_lock lock(mutex_);
+        if (auto it = index_.find(name); it != index_.end()) {
+            return it->second;
+        }
+        const string* interned = &names_.emplace_back(name);
+        index_.emplace(*interned, interned);
+        filter_.fetch_or(FilterBit(name), memory_order_release);
+        return interned;
+    }
+
+    KeyTableUsage GetUsage() {
+        shared_lock lock(mutex_);
+        KeyTableUsage usage{names_.size(), memory::DequeBytes(names_) + memory::HashTableBytes(index_)};
+        for (const string& name : names_) {
+            usage.bytes += memory::StringBytes(name);
+        }
+        return usage;
+    }
+
+private:
+    // Бит фильтра по длине и крайним байтам имени: имена из данных документа
+    // почти всегда отсеиваются им без блокировки и хеширования
+    static uint64_t FilterBit(string_view name) {
+        const size_t first = name.empty() ? 0 : static_cast<uint8_t>(name.front());
+        const size_t last = name.empty() ? 0 : static_cast<uint8_t>(name.back());
+        return uint64_t{1} << ((name.size() * 31 + first * 7 + last) & 63);
+    }
+
+    atomic<uint64_t> filter_ = 0;
+    shared_mutex mutex_;
+    deque<string> names_; // Дек не перемещает строки при росте
+    unordered_map<string_view, const string*> index_;
+};
+
+KeyTable& GetKeyTable() {
+    static KeyTable table;
+    return table;
+}
+
+bool KeyLess(const Dict::value_type& lhs, const Dict::value_type& rhs) {
+    return lhs.first != rhs.first && lhs.first.AsString() < rhs.first.AsString();
 }
 
 }  // namespace
 
+// Своё имя копируется в кучу, кроме пустого
+Key::Key(string_view name, Kind kind)
+    : data_(name.data()), size_(static_cast<uint32_t>(name.size())), kind_(kind) {
+    if (name.size() > numeric_limits<uint32_t>::max()) {
+        throw length_error("Key is too long"s);
+    }
+    if (kind_ == Kind::OWNED) {
+        if (name.empty()) {
+            data_ = "";
+            kind_ = Kind::BORROWED;
+            return;
+        }
+        char* data = new char[name.size()];
+        memcpy(data, name.data(), name.size());
+        data_ = data;
+    }
+}
+
+Key::Key(string_view name)
+    : Key(name, Kind::OWNED) {
+}
+
+Key Key::Intern(string_view name) {
+    return Key(*GetKeyTable().Intern(name), Kind::INTERNED);
+}
+
+optional<Key> Key::FindInterned(string_view name) {
+    if (const string* interned = GetKeyTable().Find(name)) {
+        return Key(*interned, Kind::INTERNED);
+    }
+    return nullopt;
+}
+
+Key Key::Borrow(string_view name) {
+    return Key(name, Kind::BORROWED);
+}
+
+// Копия может пережить документ, поэтому владеет именем, если оно не из общей таблицы
+Key::Key(const Key& other)
+    : Key(other.AsString(), other.kind_ == Kind::INTERNED ? Kind::INTERNED : Kind::OWNED) {
+}
+
+Key::Key(Key&& other) noexcept
+    : data_(other.data_), size_(other.size_), kind_(other.kind_) {
+    other.kind_ = Kind::BORROWED;
+}
+
+Key& Key::operator=(const Key& other) {
+    if (this != &other) {
+        *this = Key(other);
+    }
+    return *this;
+}
+
+Key& Key::operator=(Key&& other) noexcept {
+    if (this != &other) {
+        if (kind_ == Kind::OWNED) {
+            delete[] data_;
+        }
+        data_ = other.data_;
+        size_ = other.size_;
+        kind_ = other.kind_;
+        other.kind_ = Kind::BORROWED;
+    }
+    return *this;
+}
+
+Key::~Key() {
+    if (kind_ == Kind::OWNED) {
+        delete[] data_;
+    }
+}
+
+Dict::Dict(initializer_list<value_type> items)
+    : Dict(Items(items)) {
+}
+
+Dict::Dict(Items items)
+    : items_(move(items)) {
+    // Словари обычно малы, для них сортировка вставками быстрее и не выделяет память
+    constexpr size_t INSERTION_SORT_SIZE = 16;
+    if (items_.size() <= INSERTION_SORT_SIZE) {
+        for (auto it = items_.begin(); it != items_.end(); ++it) {
+            rotate(upper_bound(items_.begin(), it, *it, KeyLess), it, it + 1);
+        }
+    }
+    else {
+        stable_sort(items_.begin(), items_.end(), KeyLess);
+    }
+    // Из равных ключей после устойчивой сортировки первым стоит первый в тексте
+    items_.erase(unique(items_.begin(), items_.end(), [](const value_type& lhs, const value_type& rhs) {
+        return lhs.first == rhs.first;
+    }), items_.end());
+}
+
+size_t Dict::size() const {
+    return items_.size();
+}
+
+size_t Dict::capacity() const {
+    return items_.capacity();
+}
+
+bool Dict::empty() const {
+    return items_.empty();
+}
+
+Dict::Items::allocator_type Dict::get_allocator() const {
+    return items_.get_allocator();
+}
+
+Dict::const_iterator Dict::begin() const {
+    return items_.begin();
+}
+
+Dict::const_iterator Dict::end() const {
+    return items_.end();
+}
+
+Dict::Items::const_iterator Dict::LowerBound(string_view name) const {
+    return lower_bound(items_.begin(), items_.end(), name, [](const value_type& item, string_view name) {
+        return item.first.AsString() < name;
+    });
+}
+
+// В малом словаре ключ ищется просмотром подряд, в большом - двоичным поиском по имени
+Dict::const_iterator Dict::find(const Key& key) const {
+    constexpr size_t LINEAR_SEARCH_SIZE = 8;
+    if (items_.size() > LINEAR_SEARCH_SIZE) {
+        const auto it = LowerBound(key.AsString());
+        return it != items_.end() && it->first == key ? it : items_.end();
+    }
+    return std::find_if(items_.begin(), items_.end(), [&key](const value_type& item) {
+        return item.first == key;
+    });
+}
+
+Dict::const_iterator Dict::find(string_view name) const {
+    const auto it = LowerBound(name);
+    return it != items_.end() && it->first.AsString() == name ? it : items_.end();
+}
+
+bool Dict::contains(const Key& key) const {
+    return find(key) != items_.end();
+}
+
+bool Dict::contains(string_view name) const {
+    return find(name) != items_.end();
+}
+
+const Node& Dict::at(const Key& key) const {
+    const auto it = find(key);
+    if (it == items_.end()) {
+        throw out_of_range("No key "s + string(key.AsString()));
+    }
+    return it->second;
+}
+
+const Node& Dict::at(string_view name) const {
+    const auto it = find(name);
+    if (it == items_.end()) {
+        throw out_of_range("No key "s + string(name));
+    }
+    return it->second;
+}
+
+Node& Dict::operator[](Key key) {
+    auto it = items_.begin() + (LowerBound(key.AsString()) - items_.cbegin());
+    if (it == items_.end() || !(it->first == key)) {
+        it = items_.emplace(it, move(key), Node());
+    }
+    return it->second;
+}
+
+size_t Dict::erase(string_view name) {
+    const auto it = find(name);
+    if (it == items_.end()) {
+        return 0;
+    }
+    items_.erase(it);
+    return 1;
+}
+
+bool Dict::operator==(const Dict& other) const {
+    return items_ == other.items_;
+}
+
 const Node::Value& Node::GetValue() const {
     return value_;
 }
@@ -312,10 +693,13 @@ double Node::AsDouble() const {
     throw std::logic_error("wrong type!");
 }
 
-const string& Node::AsString() const {
+string_view Node::AsString() const {
     if (const auto* root = get_if<string>(&value_)) {
         return *root;
     }
+    else if (const auto* borrowed = get_if<BorrowedString>(&value_)) {
+        return borrowed->value;
+    }
     else {
         throw std::logic_error("wrong type!");
     }
@@ -381,8 +765,7 @@ bool Node::IsBool() const {
 }
  
 bool Node::IsString() const {
-    const auto* root = get_if<string>(&value_);
-    if (root) {
+    if (holds_alternative<string>(value_) || holds_alternative<BorrowedString>(value_)) {
         return true;
     }
     else {
@@ -421,6 +804,10 @@ bool Node::IsMap() const {
 }
 
 bool Node::operator==(const Node& node_) const {
+    // Своя и заимствованная строки равны, если равны их символы
+    if (IsString() && node_.IsString()) {
+        return AsString() == node_.AsString();
+    }
     return value_ == node_.value_;
 }
     
@@ -428,12 +815,34 @@ bool Node::operator!=(const Node& node_) const {
     return !(*this == node_);
 }
     
+Node::Node(const Node& other)
+    : value_(other.value_) {
+    if (const auto* borrowed = get_if<BorrowedString>(&value_)) {
+        value_ = string(borrowed->value);
+    }
+}
+
+Node& Node::operator=(const Node& other) {
+    if (this != &other) {
+        *this = Node(other);
+    }
+    return *this;
+}
+
 Document::Document(Node root)
+    : root_(make_shared<const Node>(move(root))) {
+}
+
+Document::Document(shared_ptr<const Node> root)
     : root_(move(root)) {
 }
 
 const Node& Document::GetRoot() const {
-    return root_;
+    return *root_;
+}
+
+size_t Document::GetArenaBytes() const {
+    return json::GetArenaBytes(GetRoot());
 }
 
 bool Document::operator==(const Document& other) const {
@@ -444,8 +853,56 @@ bool Document::operator!=(const Document& other) const {
     return GetRoot() != other.GetRoot();
 }
 
+// Корень объявлен после арен и разрушается раньше них
+struct DocumentArenas::Storage {
+    vector<unique_ptr<DocumentArena>> arenas;
+    Node root;
+};
+
+DocumentArenas::DocumentArenas()
+    : storage_(make_shared<Storage>()) {
+}
+
+pmr::memory_resource* DocumentArenas::Add(size_t initial_size) {
+    storage_->arenas.push_back(make_unique<DocumentArena>(initial_size, nullptr));
+    return &storage_->arenas.back()->resource;
+}
+
+Document DocumentArenas::MakeDocument(Node root) && {
+    storage_->root = move(root);
+    const Node* stored_root = &storage_->root;
+    return Document{shared_ptr<const Node>(move(storage_), stored_root)};
+}
+
 Document Load(istream& input) {
-    return Document{LoadNode(input)};
+    return Load(string_view(ReadAll(input)));
+}
+
+Document Load(string_view text) {
+    return LoadToArena(text, nullptr);
+}
+
+Document LoadFile(const string& path) {
+    auto file = make_shared<const MappedFile>(path);
+    const string_view text = file->GetData();
+    return LoadToArena(text, move(file));
+}
+
+size_t GetArenaBytes(const Node& root) {
+    pmr::memory_resource* resource = nullptr;
+    if (const auto* array = get_if<Array>(&root.GetValue())) {
+        resource = array->get_allocator().resource();
+    }
+    else if (const auto* dict = get_if<Dict>(&root.GetValue())) {
+        resource = dict->get_allocator().resource();
+    }
+    const auto* arena = dynamic_cast<const pmr::monotonic_buffer_resource*>(resource);
+    const auto* upstream = arena != nullptr ? dynamic_cast<const CountingResource*>(arena->upstream_resource()) : nullptr;
+    return upstream != nullptr ? upstream->GetBytes() : 0;
+}
+
+KeyTableUsage GetKeyTableUsage() {
+    return GetKeyTable().GetUsage();
 }
 
 struct PrintContext {
@@ -471,7 +928,7 @@ void PrintValue(const Value& value, const PrintContext& ctx) {
     ctx.out << value;
 }
 
-void PrintString(const std::string& value, std::ostream& out) {
+void PrintString(std::string_view value, std::ostream& out) {
     out.put('"');
     for (const char c : value) {
         switch (c) {
@@ -503,6 +960,11 @@ void PrintValue<std::string>(const std::string& value, const PrintContext& ctx)
     PrintString(value, ctx.out);
 }
 
+template <>
+void PrintValue<BorrowedString>(const BorrowedString& value, const PrintContext& ctx) {
+    PrintString(value.value, ctx.out);
+}
+
 template <>
 void PrintValue<std::nullptr_t>(const std::nullptr_t&, const PrintContext& ctx) {
     ctx.out << "null"sv;
@@ -550,7 +1012,7 @@ void PrintValue<Dict>(const Dict& nodes, const PrintContext& ctx) {
             out << ",\n"sv;
         }
         inner_ctx.PrintIndent();
-        PrintString(key, ctx.out);
+        PrintString(key.AsString(), ctx.out);
         out << ": "sv;
         PrintNode(node, inner_ctx);
     }
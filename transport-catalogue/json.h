@@ -4,18 +4,108 @@
 
 #pragma once
 
+#include <cstdint>
+#include <initializer_list>
 #include <iostream>
-#include <map>
+#include <memory>
+#include <memory_resource>
+#include <optional>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
 #include <variant>
 
 namespace json {
 
 class Node;
-// Сохраните объявления Dict и Array без изменения
-using Dict = std::map<std::string, Node>;
-using Array = std::vector<Node>;
+
+// Ключ словаря. Имена ключей схемы, которые читает код, хранятся один раз на весь процесс
+// (Key::Intern), и такие ключи сравниваются по указателю на имя. Остальные имена - данные
+// документа, например названия остановок в road_distances, и в общую таблицу не попадают:
+// ключ разобранного документа указывает на имя в его арене или в тексте, а ключ, созданный
+// или скопированный вне разбора, владеет своей копией имени
+class Key {
+public:
+    explicit Key(std::string_view name); // Своя копия имени
+    static Key Intern(std::string_view name); // Имя схемы: таблица только растёт, поэтому имена задаёт код, а не данные
+    static std::optional<Key> FindInterned(std::string_view name);
+    static Key Borrow(std::string_view name); // Имя должно жить дольше ключа; копия ключа скопирует его
+
+    Key(const Key& other);
+    Key(Key&& other) noexcept;
+    Key& operator=(const Key& other);
+    Key& operator=(Key&& other) noexcept;
+    ~Key();
+
+    std::string_view AsString() const {
+        return {data_, size_};
+    }
+    bool IsInterned() const {
+        return kind_ == Kind::INTERNED;
+    }
+    bool operator==(const Key& other) const {
+        if (kind_ == Kind::INTERNED && other.kind_ == Kind::INTERNED) {
+            return data_ == other.data_;
+        }
+        return AsString() == other.AsString();
+    }
+
+private:
+    enum class Kind : uint8_t {
+        INTERNED,
+        BORROWED,
+        OWNED,
+    };
+
+    Key(std::string_view name, Kind kind);
+
+    // Размер в 32 битах: пара ключа и узла в словаре меньше на 8 байт
+    const char* data_;
+    uint32_t size_;
+    Kind kind_;
+};
+
+// Словарь - непрерывный вектор пар, упорядоченный по имени ключа, как std::map.
+// При повторе ключа остаётся первое значение. Обход только на чтение: ключи не меняются
+class Dict {
+public:
+    using key_type = Key;
+    using value_type = std::pair<Key, Node>;
+    using Items = std::pmr::vector<value_type>;
+    using const_iterator = Items::const_iterator;
+
+    Dict() = default;
+    Dict(std::initializer_list<value_type> items);
+    explicit Dict(Items items); // Пары в любом порядке
+
+    size_t size() const;
+    size_t capacity() const;
+    bool empty() const;
+    Items::allocator_type get_allocator() const;
+    const_iterator begin() const;
+    const_iterator end() const;
+
+    // Поиск по ключу схемы сравнивает указатели, по остальным ключам и по имени - строки
+    const_iterator find(const Key& key) const;
+    const_iterator find(std::string_view name) const;
+    bool contains(const Key& key) const;
+    bool contains(std::string_view name) const;
+    const Node& at(const Key& key) const; // std::out_of_range, если ключа нет
+    const Node& at(std::string_view name) const;
+    Node& operator[](Key key);
+    size_t erase(std::string_view name);
+
+    bool operator==(const Dict& other) const;
+
+private:
+    Items::const_iterator LowerBound(std::string_view name) const;
+
+    Items items_;
+};
+
+// Массивы и словари разобранного документа берут память из его арены, остальные - из кучи
+using Array = std::pmr::vector<Node>;
 
 // Эта ошибка должна выбрасываться при ошибках парсинга JSON
 class ParsingError : public std::runtime_error {
@@ -23,18 +113,30 @@ public:
     using runtime_error::runtime_error;
 };
 
+// Строка, которая не владеет символами: указывает в арену документа или в буфер, из которого он разобран
+struct BorrowedString {
+    std::string_view value;
+
+    bool operator==(const BorrowedString& other) const = default;
+};
+
 class Node {
 public:
-    using Value = std::variant<std::nullptr_t, Array, Dict, bool, int, double, std::string>;
+    using Value = std::variant<std::nullptr_t, Array, Dict, bool, int, double, std::string, BorrowedString>;
     Node() = default;
  
     template <typename Type>
     Node(Type value) : value_(std::move(value)) {}
-    
+    // Копия может пережить документ, поэтому владеет своими строками и именами ключей и берёт память из кучи
+    Node(const Node& other);
+    Node(Node&& other) = default;
+    Node& operator=(const Node& other);
+    Node& operator=(Node&& other) = default;
+
     int AsInt() const;
     bool AsBool() const;
     double AsDouble() const;
-    const std::string& AsString() const;
+    std::string_view AsString() const; // И для своей строки, и для заимствованной
     const Array& AsArray() const;
     const Dict& AsMap() const;
     const Value& GetValue() const;
@@ -58,17 +160,54 @@ private:
 class Document {
 public:
     explicit Document(Node root);
+    // root держит и всё, на что ссылаются узлы; так разобранный документ владеет своей ареной
+    explicit Document(std::shared_ptr<const Node> root);
 
     const Node& GetRoot() const;
+    size_t GetArenaBytes() const; // См. json::GetArenaBytes
     bool operator==(const Document& other) const;
     bool operator!=(const Document& other) const;
     
 private:
-    Node root_;
+    std::shared_ptr<const Node> root_;
 };
 
-Document Load(std::istream& input);
+// Арены документа, который собирается вне разбора, например ответов json::Builder по кускам
+// в нескольких потоках. Каждую арену заполняет один поток; документ из MakeDocument держит
+// все арены, поэтому узлы и строки в них живут вместе с ним
+class DocumentArenas {
+public:
+    DocumentArenas();
+
+    std::pmr::memory_resource* Add(size_t initial_size = 4096);
+    Document MakeDocument(Node root) &&; // Узлы root берут память из этих арен или из кучи
+
+private:
+    struct Storage;
+
+    std::shared_ptr<Storage> storage_;
+};
+
+// Узлы, контейнеры и строки разобранного документа лежат в арене, которой он владеет:
+// выделение памяти - сдвиг указателя, а узлы не разрушаются по одному, арена освобождается целиком
+Document Load(std::istream& input); //Читает поток до конца
+Document Load(std::string_view text);
+// Отображает файл в память и разбирает его без копирования строк: строки без
+// escape-последовательностей указывают в отображение, которое живёт вместе с документом
+Document LoadFile(const std::string& path);
 
 void Print(const Document& doc, std::ostream& output);
 
+// Байты, которые арена разобранного документа взяла у кучи, вместе с незанятыми остатками её блоков.
+// Арена находится по корню: его массив или словарь берёт память из неё. 0, если корень не из арены.
+// Заимствованные строки LoadFile указывают в отображение файла и сюда не входят
+size_t GetArenaBytes(const Node& root);
+
+// Общая таблица имён ключей схемы
+struct KeyTableUsage {
+    size_t keys = 0;
+    size_t bytes = 0;
+};
+KeyTableUsage GetKeyTableUsage();
+
 }  // namespace json
\ No newline at end of file
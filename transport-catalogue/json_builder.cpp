@@ -1,20 +1,31 @@
 #include "json_builder.h"
 
+#include <cstring>
+
 namespace json {
 
 Builder::Builder() {
     root_ = Node(nullptr);
     nodes_stack_.push_back(&root_);
 }  
+
+Builder::Builder(std::pmr::memory_resource* resource)
+    : Builder() {
+    resource_ = resource;
+}
     
 Builder::KeyItemContext Builder::Key(std::string str) {
+    return Key(json::Key(str));
+}
+
+Builder::KeyItemContext Builder::Key(json::Key key) {
     if (nodes_stack_.empty()) {
         throw std::logic_error("Two times use Value()");
     }
     if (!nodes_stack_.back()->IsMap()) {
         throw std::logic_error("Key() for not Map Node");
     }
-    nodes_stack_.push_back(&(std::get<Dict>(nodes_stack_.back()->GetValue())[std::move(str)] = Node(nullptr)));
+    nodes_stack_.push_back(&(std::get<Dict>(nodes_stack_.back()->GetValue())[std::move(key)] = Node(nullptr)));
     return KeyItemContext(*this);
 }
     
@@ -39,11 +50,11 @@ Builder::DictItemContext Builder::StartDict() {
         throw std::logic_error("Usage StartDict() with complite Node");
     }
     else if (nodes_stack_.back()->IsNull()) {
-        *nodes_stack_.back() = Node(Dict());
+        *nodes_stack_.back() = Node(MakeDict());
         return DictItemContext(*this);
     }
     else if (nodes_stack_.back()->IsArray()) {
-        std::get<Array>(nodes_stack_.back()->GetValue()).emplace_back(Dict());
+        std::get<Array>(nodes_stack_.back()->GetValue()).emplace_back(MakeDict());
         nodes_stack_.push_back(&(std::get<Array>(nodes_stack_.back()->GetValue()).back()));
         return DictItemContext(*this);
     }
@@ -63,11 +74,11 @@ Builder::ArrayItemContext Builder::StartArray() {
         throw std::logic_error("Usage StartArray() with complite Node");
     }
     else if (nodes_stack_.back()->IsNull()) {
-        *nodes_stack_.back() = Node(Array());
+        *nodes_stack_.back() = Node(MakeArray());
         return ArrayItemContext(*this);
     }
     else if (nodes_stack_.back()->IsArray()) {
-        std::get<Array>(nodes_stack_.back()->GetValue()).emplace_back(Array());
+        std::get<Array>(nodes_stack_.back()->GetValue()).emplace_back(MakeArray());
         nodes_stack_.push_back(&(std::get<Array>(nodes_stack_.back()->GetValue()).back()));
         return ArrayItemContext(*this);
     }
@@ -83,16 +94,37 @@ Builder& Builder::EndArray() {
     return *this;
 }
     
+Node::Value Builder::MakeString(std::string_view value) {
+    if (resource_ == nullptr || value.empty()) {
+        return std::string(value);
+    }
+    char* data = static_cast<char*>(resource_->allocate(value.size(), 1));
+    std::memcpy(data, value.data(), value.size());
+    return BorrowedString{{data, value.size()}};
+}
+
+Dict Builder::MakeDict() const {
+    return resource_ != nullptr ? Dict(Dict::Items(resource_)) : Dict();
+}
+
+Array Builder::MakeArray() const {
+    return resource_ != nullptr ? Array(resource_) : Array();
+}
+    
 json::Node Builder::Build() {  
     if (!nodes_stack_.empty()) {
         throw std::logic_error("Invalid use of Build()");
     }
-    return root_;
+    return std::move(root_);
 }
 
 Builder::KeyItemContext Builder::DictItemContext::Key(std::string str) {
     return builder_.Key(std::move(str));
 }
+
+Builder::KeyItemContext Builder::DictItemContext::Key(json::Key key) {
+    return builder_.Key(std::move(key));
+}
     
 Builder& Builder::DictItemContext::EndDict() {
     return builder_.EndDict();
@@ -113,6 +145,10 @@ Builder::ArrayItemContext Builder::KeyItemContext::StartArray() {
 Builder::KeyItemContext Builder::ValueAfterKeyItemContext::Key(std::string str) {
     return builder_.Key(std::move(str));
 }
+
+Builder::KeyItemContext Builder::ValueAfterKeyItemContext::Key(json::Key key) {
+    return builder_.Key(std::move(key));
+}
     
 Builder& Builder::ValueAfterKeyItemContext::EndDict() {
     return builder_.EndDict();
@@ -2,27 +2,42 @@
 
 #include "json.h"
 
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <vector>
+
 namespace json {
     
 class Builder {
     Node root_{};
     std::vector<Node*> nodes_stack_;
+    std::pmr::memory_resource* resource_ = nullptr;
     
     class DictItemContext;
     class KeyItemContext;
     class ValueAfterKeyItemContext;
     class ArrayItemContext;
 
+    Dict MakeDict() const;
+    Array MakeArray() const;
+
 public:
 
     Builder();
+    // Массивы, словари и строки из MakeString берут память из resource, например из арены
+    // DocumentArenas; она должна жить, пока живут построенные узлы
+    explicit Builder(std::pmr::memory_resource* resource);
     KeyItemContext Key(std::string);
+    KeyItemContext Key(json::Key key); // Готовый ключ, например имя схемы, не копируется
     Builder& Value(Node::Value value);
     DictItemContext StartDict();
     Builder& EndDict();
     ArrayItemContext StartArray();
     Builder& EndArray();
-    json::Node Build();
+    // Значение для Value: с памятью построителя - копия строки в ней, иначе своя строка
+    Node::Value MakeString(std::string_view value);
+    json::Node Build(); // Отдаёт построенный узел, а не копию
 };  
 
 class Builder::DictItemContext {
@@ -31,6 +46,7 @@ class Builder::DictItemContext {
 public:
     DictItemContext(Builder& builder) : builder_(builder) {}
     KeyItemContext Key(std::string str);
+    KeyItemContext Key(json::Key key);
     Builder& EndDict();
 };
     
@@ -52,6 +68,7 @@ public:
     ValueAfterKeyItemContext(Builder& builder) : builder_(builder) {}
     
     KeyItemContext Key(std::string str);
+    KeyItemContext Key(json::Key key);
     Builder& EndDict();
 };
  
@@ -1,50 +1,231 @@
 #include "json_reader.h"
 #include "json_builder.h"
+#include "memory_usage.h"
 #include "router.h"
+#include "scratch_arena.h"
 #include "transport_router.h"
 
+#include <algorithm>
+#include <cmath>
+#include <future>
 #include <iterator>
+#include <limits>
+#include <memory>
+#include <stdexcept>
 #include <vector>
 #include <set>
 #include <string_view>
 #include <string>
 #include <optional>
 #include <type_traits>
+#include <variant>
 
 
 namespace transport_catalogue {
 
 using namespace std::literals;
 
-void GetBusStat(const TransportCatalogue& tansport_catalogue, const json::Node& request, json::Builder& builder) {
-    auto bus_info = tansport_catalogue.GetBusInfo(request.AsMap().at("name").AsString());
-    builder.StartDict().Key("request_id").Value(request.AsMap().at("id").AsInt());
+//Ключи, которые читаются из каждого запроса: поиск по ним сравнивает указатели, а не строки
+const json::Key TYPE_KEY = json::Key::Intern("type");
+const json::Key NAME_KEY = json::Key::Intern("name");
+const json::Key ID_KEY = json::Key::Intern("id");
+const json::Key LATITUDE_KEY = json::Key::Intern("latitude");
+const json::Key LONGITUDE_KEY = json::Key::Intern("longitude");
+const json::Key ROAD_DISTANCES_KEY = json::Key::Intern("road_distances");
+const json::Key STOPS_KEY = json::Key::Intern("stops");
+const json::Key IS_ROUNDTRIP_KEY = json::Key::Intern("is_roundtrip");
+//Ключи частых ответов: построитель не копирует их имена в каждый ответ
+const json::Key REQUEST_ID_KEY = json::Key::Intern("request_id");
+const json::Key ERROR_MESSAGE_KEY = json::Key::Intern("error_message");
+const json::Key BUSES_KEY = json::Key::Intern("buses");
+const json::Key CURVATURE_KEY = json::Key::Intern("curvature");
+const json::Key ROUTE_LENGTH_KEY = json::Key::Intern("route_length");
+const json::Key STOP_COUNT_KEY = json::Key::Intern("stop_count");
+const json::Key UNIQUE_STOP_COUNT_KEY = json::Key::Intern("unique_stop_count");
+const json::Key TOTAL_TIME_KEY = json::Key::Intern("total_time");
+const json::Key ITEMS_KEY = json::Key::Intern("items");
+const json::Key BUS_KEY = json::Key::Intern("bus");
+const json::Key STOP_NAME_KEY = json::Key::Intern("stop_name");
+const json::Key SPAN_COUNT_KEY = json::Key::Intern("span_count");
+const json::Key TIME_KEY = json::Key::Intern("time");
+const json::Key DISTANCE_KEY = json::Key::Intern("distance");
+
+//Bus и Stop отвечаются и по каталогу, и по его образу
+template <typename Catalogue>
+void GetBusStat(const Catalogue& tansport_catalogue, const json::Node& request, json::Builder& builder) {
+    auto bus_info = tansport_catalogue.GetBusInfo(request.AsMap().at(NAME_KEY).AsString());
+    builder.StartDict().Key(REQUEST_ID_KEY).Value(request.AsMap().at(ID_KEY).AsInt());
     if (!bus_info.has_value()) { 
-        builder.Key("error_message").Value("not found").EndDict();
+        builder.Key(ERROR_MESSAGE_KEY).Value("not found").EndDict();
         return;
     }
-    builder.Key("curvature").Value(bus_info->curvature)
-        .Key("route_length").Value(bus_info->length)
-        .Key("stop_count").Value(static_cast<int>(bus_info->stops_on_route))
-        .Key("unique_stop_count").Value(static_cast<int>(bus_info->unique_stops)).EndDict();
+    builder.Key(CURVATURE_KEY).Value(bus_info->curvature)
+        .Key(ROUTE_LENGTH_KEY).Value(bus_info->length)
+        .Key(STOP_COUNT_KEY).Value(static_cast<int>(bus_info->stops_on_route))
+        .Key(UNIQUE_STOP_COUNT_KEY).Value(static_cast<int>(bus_info->unique_stops)).EndDict();
 }
 
-void GetStopStat(const TransportCatalogue& tansport_catalogue, const json::Node& request, json::Builder& builder) {
-    auto buses_for_stop = tansport_catalogue.GetBusesForStop(request.AsMap().at("name").AsString());
-    builder.StartDict().Key("request_id").Value(request.AsMap().at("id").AsInt());
+template <typename Catalogue>
+void GetStopStat(const Catalogue& tansport_catalogue, const json::Node& request, json::Builder& builder, std::pmr::memory_resource* resource) {
+    auto buses_for_stop = tansport_catalogue.GetBusesForStop(request.AsMap().at(NAME_KEY).AsString(), resource);
+    builder.StartDict().Key(REQUEST_ID_KEY).Value(request.AsMap().at(ID_KEY).AsInt());
     if (!buses_for_stop.has_value()) {
-        builder.Key("error_message").Value("not found").EndDict();
+        builder.Key(ERROR_MESSAGE_KEY).Value("not found").EndDict();
         return;
     }
-    json::Array buses;
-    builder.Key("buses").StartArray();
+    builder.Key(BUSES_KEY).StartArray();
     for (auto& bus_name : *buses_for_stop) {
-        builder.Value(std::string{bus_name});
+        builder.Value(builder.MakeString(bus_name));
+    }
+    builder.EndArray().EndDict();
+}
+
+void GetNearestStops(const TransportCatalogue& tansport_catalogue, const json::Node& request, json::Builder& builder) {
+    const auto& request_map = request.AsMap();
+    const int count = request_map.contains("count") ? request_map.at("count").AsInt() : 1;
+    if (count <= 0) {
+        builder.StartDict().Key(REQUEST_ID_KEY).Value(request_map.at(ID_KEY).AsInt()).Key(ERROR_MESSAGE_KEY).Value("invalid count").EndDict();
+        return;
+    }
+    const double radius = request_map.contains("radius") ? request_map.at("radius").AsDouble() : std::numeric_limits<double>::infinity();
+    if (std::isnan(radius) || radius < 0) {
+        builder.StartDict().Key(REQUEST_ID_KEY).Value(request_map.at(ID_KEY).AsInt()).Key(ERROR_MESSAGE_KEY).Value("invalid radius").EndDict();
+        return;
+    }
+    auto stops = tansport_catalogue.NearestStops({request_map.at(LATITUDE_KEY).AsDouble(), request_map.at(LONGITUDE_KEY).AsDouble()},
+                                                    std::min<size_t>(count, tansport_catalogue.GetStops().size()), radius);
+    builder.StartDict().Key(REQUEST_ID_KEY).Value(request_map.at(ID_KEY).AsInt()).Key(STOPS_KEY).StartArray();
+    for (const auto& [stop, distance] : stops) {
+        builder.StartDict().Key(NAME_KEY).Value(builder.MakeString(stop->name)).Key(DISTANCE_KEY).Value(distance).EndDict();
+    }
+    builder.EndArray().EndDict();
+}
+
+//Все маршруты одним ответом: столбцы с теми же ключами, что в ответе Bus, и столбец имён
+void GetAllBusesStat(const TransportCatalogue& tansport_catalogue, const json::Node& request, json::Builder& builder) {
+    const BusesInfo buses_info = tansport_catalogue.GetAllBusesInfo();
+    json::Array names;
+    json::Array curvature;
+    json::Array route_length;
+    json::Array stop_count;
+    json::Array unique_stop_count;
+    names.reserve(buses_info.names.size());
+    curvature.reserve(buses_info.names.size());
+    route_length.reserve(buses_info.names.size());
+    stop_count.reserve(buses_info.names.size());
+    unique_stop_count.reserve(buses_info.names.size());
+    for (size_t i = 0; i < buses_info.names.size(); ++i) {
+        names.emplace_back(std::string{buses_info.names[i]});
+        curvature.emplace_back(buses_info.curvature[i]);
+        route_length.emplace_back(buses_info.length[i]);
+        stop_count.emplace_back(static_cast<int>(buses_info.stops_on_route[i]));
+        unique_stop_count.emplace_back(static_cast<int>(buses_info.unique_stops[i]));
+    }
+    builder.StartDict().Key(REQUEST_ID_KEY).Value(request.AsMap().at(ID_KEY).AsInt())
+        .Key(BUSES_KEY).StartDict()
+            .Key(NAME_KEY).Value(std::move(names))
+            .Key(CURVATURE_KEY).Value(std::move(curvature))
+            .Key(ROUTE_LENGTH_KEY).Value(std::move(route_length))
+            .Key(STOP_COUNT_KEY).Value(std::move(stop_count))
+            .Key(UNIQUE_STOP_COUNT_KEY).Value(std::move(unique_stop_count))
+        .EndDict().EndDict();
+}
+
+//Подсказки для автодополнения: остановки и маршруты, чьи имена начинаются с prefix
+void GetSuggestions(const TransportCatalogue& tansport_catalogue, const json::Node& request, json::Builder& builder) {
+    const auto& request_map = request.AsMap();
+    const int limit = request_map.contains("limit") ? request_map.at("limit").AsInt() : 10;
+    if (limit < 0) {
+        builder.StartDict().Key(REQUEST_ID_KEY).Value(request_map.at(ID_KEY).AsInt()).Key(ERROR_MESSAGE_KEY).Value("invalid limit").EndDict();
+        return;
+    }
+    const std::string_view prefix = request_map.at("prefix").AsString();
+    builder.StartDict().Key(REQUEST_ID_KEY).Value(request_map.at(ID_KEY).AsInt()).Key(STOPS_KEY).StartArray();
+    for (std::string_view name : tansport_catalogue.SuggestStops(prefix, limit)) {
+        builder.Value(builder.MakeString(name));
+    }
+    builder.EndArray().Key(BUSES_KEY).StartArray();
+    for (std::string_view name : tansport_catalogue.SuggestBuses(prefix, limit)) {
+        builder.Value(builder.MakeString(name));
     }
     builder.EndArray().EndDict();
 }
 
-std::vector<std::string_view> MakeStopsNamesVector(const std::vector<json::Node>& stops) {
+//Узлы JSON, построенного в куче, и всё, что они выделили
+void AddJsonMemoryUsage(const json::Node& node, memory::Usage& usage) {
+    ++usage.elements;
+    if (const auto* array = std::get_if<json::Array>(&node.GetValue())) {
+        usage.bytes += memory::VectorBytes(*array);
+        for (const auto& item : *array) {
+            AddJsonMemoryUsage(item, usage);
+        }
+    }
+    else if (const auto* dict = std::get_if<json::Dict>(&node.GetValue())) {
+        usage.bytes += memory::AllocationSize(dict->capacity() * sizeof(json::Dict::value_type));
+        for (const auto& [key, item] : *dict) {
+            //Имена ключей схемы лежат в общей таблице, она считается отдельно
+            if (!key.IsInterned()) {
+                usage.bytes += memory::AllocationSize(key.AsString().size());
+            }
+            AddJsonMemoryUsage(item, usage);
+        }
+    }
+    else if (const auto* string = std::get_if<std::string>(&node.GetValue())) {
+        usage.bytes += memory::StringBytes(*string);
+    }
+}
+
+json::Node::Value MakeSizeValue(size_t size) {
+    if (size <= static_cast<size_t>(std::numeric_limits<int>::max())) {
+        return static_cast<int>(size);
+    }
+    return static_cast<double>(size);
+}
+
+void GetMemoryStat(const TransportCatalogue& tansport_catalogue, const std::optional<graph::RoutesManager>& routes_manager, const json::Node& catalogue_data, const json::Node& request, json::Builder& builder) {
+    memory::Report report = tansport_catalogue.GetMemoryUsage();
+    for (memory::Usage& usage : routes_manager->GetMemoryUsage()) {
+        report.push_back(std::move(usage));
+    }
+    memory::Usage document{"json.document", sizeof(json::Node), 0};
+    AddJsonMemoryUsage(catalogue_data, document);
+    //Разобранный документ со всеми строками лежит в арене: считаются её блоки, а не узлы
+    if (const size_t arena_bytes = json::GetArenaBytes(catalogue_data); arena_bytes != 0) {
+        document.bytes = arena_bytes;
+    }
+    report.push_back(std::move(document));
+    const json::KeyTableUsage keys = json::GetKeyTableUsage();
+    report.push_back({"json.keys", keys.bytes, keys.keys});
+
+    size_t total_bytes = 0;
+    builder.StartDict().Key(REQUEST_ID_KEY).Value(request.AsMap().at(ID_KEY).AsInt()).Key("structures").StartArray();
+    for (const memory::Usage& usage : report) {
+        builder.StartDict().Key("name").Value(usage.name)
+            .Key("bytes").Value(MakeSizeValue(usage.bytes))
+            .Key("elements").Value(MakeSizeValue(usage.elements));
+        if (usage.buckets) {
+            builder.Key("buckets").Value(MakeSizeValue(*usage.buckets)).Key("load_factor").Value(usage.load_factor.value_or(0.0));
+        }
+        builder.EndDict();
+        total_bytes += usage.bytes;
+    }
+    builder.EndArray().Key("total_bytes").Value(MakeSizeValue(total_bytes)).EndDict();
+}
+
+//Конец маршрута задаётся названием остановки или координатами {"latitude", "longitude"};
+//координаты привязываются к ближайшей остановке
+std::optional<std::string_view> GetRouteEndpoint(const TransportCatalogue& tansport_catalogue, const json::Node& endpoint) {
+    if (endpoint.IsString()) {
+        return endpoint.AsString();
+    }
+    auto stops = tansport_catalogue.NearestStops({endpoint.AsMap().at(LATITUDE_KEY).AsDouble(), endpoint.AsMap().at(LONGITUDE_KEY).AsDouble()}, 1);
+    if (stops.empty()) {
+        return std::nullopt;
+    }
+    return stops.front().first->name;
+}
+
+std::vector<std::string_view> MakeStopsNamesVector(const json::Array& stops) {
     std::vector<std::string_view> results;
     for (const auto& stop : stops) {
         results.push_back(stop.AsString());
@@ -53,16 +234,9 @@ std::vector<std::string_view> MakeStopsNamesVector(const std::vector<json::Node>
 }
 
 
-//В случае некольцевого маршрута добавляет остановки от конца к началу. Было A->B->C, стало A->B->C->B->A
-std::vector<std::string_view> ParseRoute(const std::vector<std::string_view>& stops) {
-    std::vector<std::string_view> results(stops.begin(), stops.end());
-    results.insert(results.end(), std::next(stops.rbegin()), stops.rend());
-    return results;
-}
-
 svg::Color GetColorFromJson(const json::Node& color) {
     if (color.IsString()) {
-        return color.AsString();
+        return std::string(color.AsString());
     }
     else if ((color.IsArray()) and (color.AsArray().size() == 3)) {
         return svg::Rgb{static_cast<uint8_t>(color.AsArray().at(0).AsInt()), static_cast<uint8_t>(color.AsArray().at(1).AsInt()), static_cast<uint8_t>(color.AsArray().at(2).AsInt())};
@@ -95,96 +269,349 @@ RenderSettings ParseRenderSettings(const json::Node& catalogue_data) {
     };
 }
  
-std::map<std::string_view, RouteInfo> GetAllBuses(const TransportCatalogue& tansport_catalogue, const json::Node& catalogue_data) {
-    const auto& base_requests = catalogue_data.AsMap().at("base_requests").AsArray();
+std::optional<RenderSettings> LoadRenderSettingsFromJson(const json::Node& catalogue_data) {
+    if (!catalogue_data.AsMap().contains("render_settings")) {
+        return std::nullopt;
+    }
+    return ParseRenderSettings(catalogue_data);
+}
+ 
+std::map<std::string_view, RouteInfo> GetAllBuses(const TransportCatalogue& tansport_catalogue) {
     std::map<std::string_view, RouteInfo> answer;
-    for (const auto& request : base_requests) {
-        if (request.AsMap().at("type").AsString() == "Bus") {
-            const Bus* bus = tansport_catalogue.FindBus(request.AsMap().at("name").AsString());
-            if ((bus->stops.empty()) || (bus->stops.size() < 3)) {
-                continue;
-            }
-            std::vector<Stop> stops;
-            for (const auto* stop : bus->stops) {
-                stops.push_back(*stop);
-            }
-            answer.insert({bus->name, {std::move(stops), request.AsMap().at("is_roundtrip").AsBool()}});
-        }  
-        
+    for (const Bus& bus : tansport_catalogue.GetBuses()) {
+        const RouteStops route = tansport_catalogue.GetRouteStops(bus);
+        if (route.size() < 3) {
+            continue;
+        }
+        answer.insert({bus.name, {std::vector<Stop>(route.begin(), route.end()), bus.is_roundtrip}});
     }
     return answer;
 } 
 
-void LoadCatalogueFromJson(TransportCatalogue& catalogue, const json::Node& root) {
-    catalogue.AddSpeedAndWait(root.AsMap().at("routing_settings").AsMap().at("bus_velocity").AsDouble(), root.AsMap().at("routing_settings").AsMap().at("bus_wait_time").AsInt());
-    const auto& base_requests = root.AsMap().at("base_requests").AsArray();
+//Известная остановка переносится на новые координаты, остальные добавляются
+void LoadStops(TransportCatalogue& catalogue, const json::Array& base_requests) {
     for (const auto& base_request_data : base_requests) {
         const auto& base_request_data_map = base_request_data.AsMap();
-        if (base_request_data_map.at("type").AsString() == "Stop") {
-            catalogue.AddStop(base_request_data_map.at("name").AsString(), {base_request_data_map.at("latitude").AsDouble(), base_request_data_map.at("longitude").AsDouble()});
+        if (base_request_data_map.at(TYPE_KEY).AsString() == "Stop") {
+            const std::string_view name = base_request_data_map.at(NAME_KEY).AsString();
+            const Coordinates coordinates{base_request_data_map.at(LATITUDE_KEY).AsDouble(), base_request_data_map.at(LONGITUDE_KEY).AsDouble()};
+            if (catalogue.FindStop(name) != nullptr) {
+                catalogue.MoveStop(name, coordinates);
+            }
+            else {
+                catalogue.AddStop(name, coordinates);
+            }
         }
     }
+}
+
+void LoadDistances(TransportCatalogue& catalogue, const json::Array& base_requests) {
     for (const auto& base_request_data : base_requests) {
         const auto& base_request_data_map = base_request_data.AsMap();
-        if (base_request_data_map.at("type").AsString() == "Stop") {
-            for (auto& road_distance : base_request_data_map.at("road_distances").AsMap()) {
-                catalogue.AddDistance(base_request_data_map.at("name").AsString(), road_distance.first, road_distance.second.AsInt());
+        if (base_request_data_map.at(TYPE_KEY).AsString() == "Stop") {
+            for (auto& road_distance : base_request_data_map.at(ROAD_DISTANCES_KEY).AsMap()) {
+                catalogue.AddDistance(base_request_data_map.at(NAME_KEY).AsString(), road_distance.first.AsString(), road_distance.second.AsInt());
             }
         }
     }
+}
+
+//Повторно заданный маршрут заменяет прежний
+void LoadBuses(TransportCatalogue& catalogue, const json::Array& base_requests) {
+    for (const auto& base_request_data : base_requests) {
+        const auto& base_request_data_map = base_request_data.AsMap();
+        if (base_request_data_map.at(TYPE_KEY).AsString() == "Bus") {
+            auto stops_names_vector = MakeStopsNamesVector(base_request_data_map.at(STOPS_KEY).AsArray());
+            catalogue.AddBus(base_request_data_map.at(NAME_KEY).AsString(), stops_names_vector, base_request_data_map.at(IS_ROUNDTRIP_KEY).AsBool());
+        }
+    }
+}
+
+void LoadCatalogueFromJson(TransportCatalogue& catalogue, const json::Node& root) {
+    catalogue.AddSpeedAndWait(root.AsMap().at("routing_settings").AsMap().at("bus_velocity").AsDouble(), root.AsMap().at("routing_settings").AsMap().at("bus_wait_time").AsInt());
+    const auto& base_requests = root.AsMap().at("base_requests").AsArray();
+    LoadStops(catalogue, base_requests);
+    //Набор остановок больше не меняется: имена в расстояниях и маршрутах ищутся совершенным хешем
+    catalogue.FreezeNames();
+    LoadDistances(catalogue, base_requests);
+    LoadBuses(catalogue, base_requests);
+    catalogue.BuildIndexes();
+}
+
+//Запросы RemoveBus или RemoveStop с именем удаляют маршрут или остановку
+void RemoveByType(TransportCatalogue& catalogue, const json::Array& base_requests, std::string_view type) {
     for (const auto& base_request_data : base_requests) {
         const auto& base_request_data_map = base_request_data.AsMap();
-        if (base_request_data_map.at("type").AsString() == "Bus") {
-            auto stops_names_vector = MakeStopsNamesVector(base_request_data_map.at("stops").AsArray());
-            catalogue.AddBus(base_request_data_map.at("name").AsString(), (base_request_data_map.at("is_roundtrip").AsBool() ? stops_names_vector : ParseRoute(stops_names_vector)));
-            catalogue.AddRoundtripInfo(base_request_data_map.at("name").AsString(), base_request_data_map.at("is_roundtrip").AsBool());
+        if (base_request_data_map.at(TYPE_KEY).AsString() == type) {
+            const std::string_view name = base_request_data_map.at(NAME_KEY).AsString();
+            if (type == "RemoveBus") {
+                catalogue.RemoveBus(name);
+            }
+            else {
+                catalogue.RemoveStop(name);
+            }
         }
     }
 }
 
+//Индексы каталога поддерживаются при изменениях, поэтому заново не строятся.
+//Маршруты удаляются до загрузки, а остановки после: удалить можно остановку,
+//с которой в этом же обновлении сняты проходившие через неё маршруты
+void ApplyBaseRequests(TransportCatalogue& catalogue, const json::Array& base_requests) {
+    RemoveByType(catalogue, base_requests, "RemoveBus");
+    LoadStops(catalogue, base_requests);
+    LoadDistances(catalogue, base_requests);
+    LoadBuses(catalogue, base_requests);
+    RemoveByType(catalogue, base_requests, "RemoveStop");
+}
+
 struct SolutionPrinter {
     json::Builder& builder;
     void operator()(const graph::BusRiding& bus_riding) const {
-        builder.StartDict().Key("type").Value("Bus").Key("bus").Value(std::string(bus_riding.name)).Key("span_count").Value(bus_riding.span_count).Key("time").Value(bus_riding.time).EndDict();    
+        builder.StartDict().Key(TYPE_KEY).Value("Bus").Key(BUS_KEY).Value(builder.MakeString(bus_riding.name)).Key(SPAN_COUNT_KEY).Value(bus_riding.span_count).Key(TIME_KEY).Value(bus_riding.time).EndDict();    
     }
     void operator()(const graph::Waiting& waiting) const {
-        builder.StartDict().Key("type").Value("Wait").Key("stop_name").Value(std::string(waiting.name)).Key("time").Value(waiting.time).EndDict();          
+        builder.StartDict().Key(TYPE_KEY).Value("Wait").Key(STOP_NAME_KEY).Value(builder.MakeString(waiting.name)).Key(TIME_KEY).Value(waiting.time).EndDict();          
     }
 };
 
 void MakeRouteJson(const std::optional<graph::RouteInfo>& route, const json::Node& request, json::Builder& builder) {
     builder.StartDict();
     if (!route.has_value()) {
-        builder.Key("request_id").Value(request.AsMap().at("id").AsInt()).Key("error_message").Value("not found").EndDict();
+        builder.Key(REQUEST_ID_KEY).Value(request.AsMap().at(ID_KEY).AsInt()).Key(ERROR_MESSAGE_KEY).Value("not found").EndDict();
         return;
     }
-    builder.Key("request_id").Value(request.AsMap().at("id").AsInt()).Key("total_time").Value(route.value().total_time).Key("items").StartArray();
-    for (auto route_unit : route.value().route_units) {
+    builder.Key(REQUEST_ID_KEY).Value(request.AsMap().at(ID_KEY).AsInt()).Key(TOTAL_TIME_KEY).Value(route.value().total_time).Key(ITEMS_KEY).StartArray();
+    for (const auto& route_unit : route.value().route_units) {
         std::visit(SolutionPrinter{builder}, route_unit);
     }
     builder.EndArray().EndDict();
 }
 
+//Маршрутизатор строится за куб числа остановок, поэтому только если он нужен запросам
+bool NeedsRoutesManager(json::Array::const_iterator begin, json::Array::const_iterator end) {
+    return std::any_of(begin, end, [](const json::Node& request) {
+        const auto& type = request.AsMap().at(TYPE_KEY).AsString();
+        return type == "Route" || type == "Memory";
+    });
+}
+
+void MakeAnswer(const TransportCatalogue& tansport_catalogue, const std::optional<graph::RoutesManager>& routes_manager, const std::optional<RenderSettings>& render_settings, const json::Node& catalogue_data, const json::Node& request, json::Builder& builder,
+                std::pmr::memory_resource* resource) {
+    if (request.AsMap().at(TYPE_KEY).AsString() == "Bus") {
+        GetBusStat(tansport_catalogue, request, builder);
+    }
+    else if (request.AsMap().at(TYPE_KEY).AsString() == "Stop") {
+        GetStopStat(tansport_catalogue, request, builder, resource);
+    }
+    else if (request.AsMap().at(TYPE_KEY).AsString() == "Map") {
+        builder.StartDict().Key(REQUEST_ID_KEY).Value(request.AsMap().at(ID_KEY).AsInt()).Key("map").Value(GetMapJson(render_settings.value(), GetAllBuses(tansport_catalogue))).EndDict();
+    }
+    else if (request.AsMap().at(TYPE_KEY).AsString() == "Route") {
+        auto from = GetRouteEndpoint(tansport_catalogue, request.AsMap().at("from"));
+        auto to = GetRouteEndpoint(tansport_catalogue, request.AsMap().at("to"));
+        MakeRouteJson(from && to ? routes_manager->GetRoute(*from, *to, resource) : std::nullopt, request, builder);
+    }
+    else if (request.AsMap().at(TYPE_KEY).AsString() == "NearestStops") {
+        GetNearestStops(tansport_catalogue, request, builder);
+    }
+    else if (request.AsMap().at(TYPE_KEY).AsString() == "AllBuses") {
+        GetAllBusesStat(tansport_catalogue, request, builder);
+    }
+    else if (request.AsMap().at(TYPE_KEY).AsString() == "Suggest") {
+        GetSuggestions(tansport_catalogue, request, builder);
+    }
+    else if (request.AsMap().at(TYPE_KEY).AsString() == "Memory") {
+        GetMemoryStat(tansport_catalogue, routes_manager, catalogue_data, request, builder);
+    }
+    //Обновления применяются только к версиям каталога, см. ParseAndMakeAnswers(CatalogueVersions&, ...)
+    else if (request.AsMap().at(TYPE_KEY).AsString() == "Update") {
+        builder.StartDict().Key(REQUEST_ID_KEY).Value(request.AsMap().at(ID_KEY).AsInt()).Key(ERROR_MESSAGE_KEY).Value("not supported").EndDict();
+    }
+}
+
 json::Document ParseAndMakeAnswers(const TransportCatalogue& tansport_catalogue, const json::Node& catalogue_data) {
+    return ParseAndMakeAnswers(tansport_catalogue, LoadRenderSettingsFromJson(catalogue_data), catalogue_data);
+}
+
+json::Document ParseAndMakeAnswers(const TransportCatalogue& tansport_catalogue, const json::Node& catalogue_data, ThreadPool& pool) {
+    return ParseAndMakeAnswers(tansport_catalogue, LoadRenderSettingsFromJson(catalogue_data), catalogue_data, pool);
+}
+
+json::Document ParseAndMakeAnswers(const TransportCatalogue& tansport_catalogue, const std::optional<RenderSettings>& render_settings, const json::Node& catalogue_data) {
     const auto& stat_requests = catalogue_data.AsMap().at("stat_requests").AsArray();
-    json::Builder builder{};
-    const graph::RoutesManager routes_manager(tansport_catalogue);
+    json::DocumentArenas answers_arenas;
+    json::Builder builder(answers_arenas.Add());
+    std::optional<graph::RoutesManager> routes_manager;
+    if (NeedsRoutesManager(stat_requests.begin(), stat_requests.end())) {
+        routes_manager.emplace(tansport_catalogue);
+    }
+    //Одна арена на все запросы: после каждого она сбрасывается, а не освобождается
+    ScratchArena arena;
     builder.StartArray();
     for (const auto& request : stat_requests) {
-        if (request.AsMap().at("type").AsString() == "Bus") {
-            GetBusStat(tansport_catalogue, request, builder);
-        }
-        else if (request.AsMap().at("type").AsString() == "Stop") {
-            GetStopStat(tansport_catalogue, request, builder);
+        MakeAnswer(tansport_catalogue, routes_manager, render_settings, catalogue_data, request, builder, arena.GetResource());
+        arena.Reset();
+    }
+    return std::move(answers_arenas).MakeDocument(builder.EndArray().Build());
+}
+
+json::Document ParseAndMakeAnswers(const CatalogueImage& catalogue_image, const json::Node& catalogue_data) {
+    const auto& stat_requests = catalogue_data.AsMap().at("stat_requests").AsArray();
+    json::DocumentArenas answers_arenas;
+    json::Builder builder(answers_arenas.Add());
+    ScratchArena arena;
+    builder.StartArray();
+    for (const auto& request : stat_requests) {
+        const auto& type = request.AsMap().at(TYPE_KEY).AsString();
+        if (type == "Bus") {
+            GetBusStat(catalogue_image, request, builder);
         }
-        else if (request.AsMap().at("type").AsString() == "Map") {
-            builder.StartDict().Key("request_id").Value(request.AsMap().at("id").AsInt()).Key("map").Value(GetMapJson(ParseRenderSettings(catalogue_data), GetAllBuses(tansport_catalogue, catalogue_data))).EndDict();
+        else if (type == "Stop") {
+            GetStopStat(catalogue_image, request, builder, arena.GetResource());
+            arena.Reset();
         }
-        else if (request.AsMap().at("type").AsString() == "Route") {
-            MakeRouteJson(routes_manager.GetRoute(request.AsMap().at("from").AsString(), request.AsMap().at("to").AsString()), request, builder);
+        else {
+            builder.StartDict().Key(REQUEST_ID_KEY).Value(request.AsMap().at(ID_KEY).AsInt()).Key(ERROR_MESSAGE_KEY).Value("not supported").EndDict();
         }
     }
-    return json::Document{builder.EndArray().Build()};
+    return std::move(answers_arenas).MakeDocument(builder.EndArray().Build());
+}
+
+json::Document JoinChunks(std::vector<std::future<json::Array>>& chunks, json::DocumentArenas answers_arenas, size_t answers_count) {
+    json::Array answers(answers_arenas.Add(answers_count * sizeof(json::Node)));
+    answers.reserve(answers_count);
+    for (auto& chunk : chunks) {
+        json::Array chunk_answers = chunk.get();
+        std::move(chunk_answers.begin(), chunk_answers.end(), std::back_inserter(answers));
+    }
+    return std::move(answers_arenas).MakeDocument(std::move(answers));
+}
+
+//Каталог и маршрутизатор только читаются, поэтому запросы независимы.
+//Каждый кусок собирает ответы в свой массив в своей арене, массивы склеиваются в исходном порядке.
+json::Document ParseAndMakeAnswers(const TransportCatalogue& tansport_catalogue, const std::optional<RenderSettings>& render_settings, const json::Node& catalogue_data, ThreadPool& pool) {
+    const auto& stat_requests = catalogue_data.AsMap().at("stat_requests").AsArray();
+    std::optional<graph::RoutesManager> routes_manager;
+    if (NeedsRoutesManager(stat_requests.begin(), stat_requests.end())) {
+        routes_manager.emplace(tansport_catalogue);
+    }
+    //Несколько кусков на поток, чтобы простаивающие потоки могли забрать работу у занятых
+    const size_t chunk_size = std::max<size_t>(1, stat_requests.size() / (4 * pool.GetThreadsCount()));
+    json::DocumentArenas answers_arenas;
+    std::vector<std::future<json::Array>> chunks;
+    for (size_t begin = 0; begin < stat_requests.size(); begin += chunk_size) {
+        const size_t end = std::min(begin + chunk_size, stat_requests.size());
+        chunks.push_back(pool.Submit([&, begin, end, resource = answers_arenas.Add()] {
+            json::Builder builder(resource);
+            ScratchArena& arena = GetThreadScratchArena(); //Потоки не делят память
+            builder.StartArray();
+            for (size_t i = begin; i < end; ++i) {
+                MakeAnswer(tansport_catalogue, routes_manager, render_settings, catalogue_data, stat_requests[i], builder, arena.GetResource());
+                arena.Reset();
+            }
+            json::Node answers = builder.EndArray().Build();
+            return std::move(std::get<json::Array>(answers.GetValue()));
+        }));
+    }
+    return JoinChunks(chunks, std::move(answers_arenas), stat_requests.size());
 }
     
-} //trancport_catalogue
\ No newline at end of file
+namespace {
+
+//Версия каталога и маршрутизатор по ней для запросов между двумя обновлениями
+struct VersionState {
+    std::shared_ptr<const CatalogueSnapshot> snapshot;
+    std::optional<graph::RoutesManager> routes_manager;
+};
+
+bool IsUpdateRequest(const json::Node& request) {
+    return request.AsMap().at(TYPE_KEY).AsString() == "Update";
+}
+
+std::shared_ptr<const VersionState> MakeVersionState(const CatalogueVersions& versions, json::Array::const_iterator begin, json::Array::const_iterator end) {
+    auto state = std::make_shared<VersionState>();
+    state->snapshot = versions.Get();
+    if (NeedsRoutesManager(begin, end)) {
+        state->routes_manager.emplace(state->snapshot->catalogue);
+    }
+    return state;
+}
+
+//Неудачное обновление не публикуется, каталог остаётся прежним
+void ApplyUpdate(CatalogueVersions& versions, const json::Node& request, json::Builder& builder) {
+    builder.StartDict().Key(REQUEST_ID_KEY).Value(request.AsMap().at(ID_KEY).AsInt());
+    try {
+        const uint64_t version = versions.Update([&request](TransportCatalogue& catalogue) {
+            ApplyBaseRequests(catalogue, request.AsMap().at("base_requests").AsArray());
+        });
+        builder.Key("version").Value(MakeSizeValue(version));
+    }
+    catch (const std::exception&) {
+        builder.Key(ERROR_MESSAGE_KEY).Value("invalid update");
+    }
+    builder.EndDict();
+}
+
+} //namespace
+
+json::Document ParseAndMakeAnswers(CatalogueVersions& versions, const std::optional<RenderSettings>& render_settings, const json::Node& catalogue_data) {
+    const auto& stat_requests = catalogue_data.AsMap().at("stat_requests").AsArray();
+    json::DocumentArenas answers_arenas;
+    json::Builder builder(answers_arenas.Add());
+    ScratchArena arena;
+    builder.StartArray();
+    for (auto begin = stat_requests.begin(); begin != stat_requests.end();) {
+        if (IsUpdateRequest(*begin)) {
+            ApplyUpdate(versions, *begin++, builder);
+            continue;
+        }
+        const auto end = std::find_if(begin, stat_requests.end(), IsUpdateRequest);
+        const auto state = MakeVersionState(versions, begin, end);
+        for (; begin != end; ++begin) {
+            MakeAnswer(state->snapshot->catalogue, state->routes_manager, render_settings, catalogue_data, *begin, builder, arena.GetResource());
+            arena.Reset();
+        }
+    }
+    return std::move(answers_arenas).MakeDocument(builder.EndArray().Build());
+}
+
+//Запросы до обновления ещё выполняются пулом по своей версии, пока обновление собирает следующую
+json::Document ParseAndMakeAnswers(CatalogueVersions& versions, const std::optional<RenderSettings>& render_settings, const json::Node& catalogue_data, ThreadPool& pool) {
+    const auto& stat_requests = catalogue_data.AsMap().at("stat_requests").AsArray();
+    const size_t chunk_size = std::max<size_t>(1, stat_requests.size() / (4 * pool.GetThreadsCount()));
+    json::DocumentArenas answers_arenas;
+    std::vector<std::future<json::Array>> chunks;
+    for (auto begin = stat_requests.begin(); begin != stat_requests.end();) {
+        if (IsUpdateRequest(*begin)) {
+            json::Builder builder{};
+            builder.StartArray();
+            ApplyUpdate(versions, *begin++, builder);
+            json::Node answers = builder.EndArray().Build();
+            std::promise<json::Array> answer;
+            answer.set_value(std::move(std::get<json::Array>(answers.GetValue())));
+            chunks.push_back(answer.get_future());
+            continue;
+        }
+        const auto end = std::find_if(begin, stat_requests.end(), IsUpdateRequest);
+        const auto state = MakeVersionState(versions, begin, end);
+        for (; begin != end;) {
+            const auto chunk_end = begin + std::min<std::ptrdiff_t>(chunk_size, end - begin);
+            chunks.push_back(pool.Submit([&, state, begin, chunk_end, resource = answers_arenas.Add()] {
+                json::Builder builder(resource);
+                ScratchArena& arena = GetThreadScratchArena();
+                builder.StartArray();
+                for (auto it = begin; it != chunk_end; ++it) {
+                    MakeAnswer(state->snapshot->catalogue, state->routes_manager, render_settings, catalogue_data, *it, builder, arena.GetResource());
+                    arena.Reset();
+                }
+                json::Node answers = builder.EndArray().Build();
+                return std::move(std::get<json::Array>(answers.GetValue()));
+            }));
+            begin = chunk_end;
+        }
+    }
+    return JoinChunks(chunks, std::move(answers_arenas), stat_requests.size());
+}
+
+} //trancport_catalogue
@@ -1,18 +1,49 @@
 #pragma once
 #include "json.h"
+#include "json_builder.h"
 #include "transport_catalogue.h"
+#include "catalogue_versions.h"
+#include "catalogue_image.h"
 #include "map_renderer.h"
 #include "domain.h"
 #include "graph.h"
+#include "transport_router.h"
+#include "thread_pool.h"
 
+#include <future>
+#include <memory_resource>
+#include <optional>
 #include <vector>
 #include <string_view>
 #include <string>
 
 namespace transport_catalogue {
   
-std::map<std::string_view, RouteInfo> GetAllBuses(const TransportCatalogue& tansport_catalogue, const json::Node& catalogue_data); //Используется при отрисовки карты  
+std::map<std::string_view, RouteInfo> GetAllBuses(const TransportCatalogue& tansport_catalogue); //Используется при отрисовки карты  
+std::optional<RenderSettings> LoadRenderSettingsFromJson(const json::Node& catalogue_data); //nullopt, если настроек отрисовки нет
 json::Document ParseAndMakeAnswers(const TransportCatalogue& tansport_catalogue, const json::Node& catalogue_data);
+json::Document ParseAndMakeAnswers(const TransportCatalogue& tansport_catalogue, const json::Node& catalogue_data, ThreadPool& pool); //Запросы выполняются параллельно
+//Настройки отрисовки передаются отдельно, например загруженные из снимка каталога
+json::Document ParseAndMakeAnswers(const TransportCatalogue& tansport_catalogue, const std::optional<RenderSettings>& render_settings, const json::Node& catalogue_data);
+json::Document ParseAndMakeAnswers(const TransportCatalogue& tansport_catalogue, const std::optional<RenderSettings>& render_settings, const json::Node& catalogue_data, ThreadPool& pool);
+//По образу каталога отвечает только на Bus и Stop, на остальные - "not supported"
+json::Document ParseAndMakeAnswers(const CatalogueImage& catalogue_image, const json::Node& catalogue_data);
+//В JSON только int, большие размеры выводятся числом с плавающей точкой
+json::Node::Value MakeSizeValue(size_t size);
+//Ответ на один запрос; маршрутизатор нужен только запросам Route и Memory.
+//Временные структуры запроса берутся из resource, сам ответ - из памяти построителя.
+void MakeAnswer(const TransportCatalogue& tansport_catalogue, const std::optional<graph::RoutesManager>& routes_manager, const std::optional<RenderSettings>& render_settings, const json::Node& catalogue_data, const json::Node& request, json::Builder& builder,
+                std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+//Склеивает ответы кусков в исходном порядке; документ держит арены, в которых куски их строили
+json::Document JoinChunks(std::vector<std::future<json::Array>>& chunks, json::DocumentArenas answers_arenas, size_t answers_count);
 void LoadCatalogueFromJson(TransportCatalogue& catalogue, const json::Node& root);
+//Остановки и маршруты из base_requests добавляются или заменяют известные с теми же именами,
+//{"type": "RemoveBus" или "RemoveStop", "name": ...} удаляют их. Неизвестное имя - std::out_of_range,
+//остановка, через которую проходят маршруты, - std::invalid_argument
+void ApplyBaseRequests(TransportCatalogue& catalogue, const json::Array& base_requests);
+//Запросы по версиям каталога: запрос Update с массивом base_requests публикует новую версию,
+//запросы после него отвечаются по ней, а запросы до него - по прежней
+json::Document ParseAndMakeAnswers(CatalogueVersions& versions, const std::optional<RenderSettings>& render_settings, const json::Node& catalogue_data);
+json::Document ParseAndMakeAnswers(CatalogueVersions& versions, const std::optional<RenderSettings>& render_settings, const json::Node& catalogue_data, ThreadPool& pool);
     
 }
\ No newline at end of file
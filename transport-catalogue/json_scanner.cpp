@@ -0,0 +1,369 @@
+#include "json_scanner.h"
+#include "json_scanner_kernel.h"
+#include "json.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+// Маски на SSE2 есть в любой сборке под x86-64, на AVX2 - если их поддерживает процессор (см. cpu_features.h)
+#if !defined(TRANSPORT_CATALOGUE_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64))
+#include <emmintrin.h>
+#define JSON_SCANNER_SSE2
+#endif
+
+using namespace std;
+
+namespace json {
+
+namespace {
+
+using scanner_kernel::BLOCK_SIZE;
+using scanner_kernel::BlockMasks;
+// Блоков за один вызов ScanBatch: позиции пачки помещаются в кеш
+constexpr size_t BATCH_BLOCKS = 256;
+
+#if defined(JSON_SCANNER_SSE2)
+uint64_t Equal(const __m128i (&parts)[4], char c) {
+    const __m128i value = _mm_set1_epi8(c);
+    uint64_t mask = 0;
+    for (int i = 0; i < 4; ++i) {
+        mask |= static_cast<uint64_t>(static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(parts[i], value)))) << (16 * i);
+    }
+    return mask;
+}
+
+BlockMasks Classify(const char* block) {
+    __m128i parts[4];
+    __m128i folded[4];
+    for (int i = 0; i < 4; ++i) {
+        parts[i] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 16 * i));
+        // [ и { отличаются только битом 0x20, как и ] и }
+        folded[i] = _mm_or_si128(parts[i], _mm_set1_epi8(0x20));
+    }
+    BlockMasks masks;
+    masks.backslash = Equal(parts, '\\');
+    masks.quote = Equal(parts, '"');
+    masks.newline = Equal(parts, '\n') | Equal(parts, '\r');
+    masks.whitespace = masks.newline | Equal(parts, ' ') | Equal(parts, '\t');
+    masks.operators = Equal(folded, '{') | Equal(folded, '}') | Equal(parts, ':') | Equal(parts, ',');
+    for (int i = 0; i < 4; ++i) {
+        masks.non_ascii |= static_cast<uint64_t>(static_cast<uint32_t>(_mm_movemask_epi8(parts[i]))) << (16 * i);
+    }
+    return masks;
+}
+#else
+BlockMasks Classify(const char* block) {
+    BlockMasks masks;
+    for (size_t i = 0; i < BLOCK_SIZE; ++i) {
+        const uint64_t bit = uint64_t{1} << i;
+        switch (block[i]) {
+            case '\\':
+                masks.backslash |= bit;
+                break;
+            case '"':
+                masks.quote |= bit;
+                break;
+            case '\n':
+            case '\r':
+                masks.newline |= bit;
+                masks.whitespace |= bit;
+                break;
+            case ' ':
+            case '\t':
+                masks.whitespace |= bit;
+                break;
+            case '{':
+            case '}':
+            case '[':
+            case ']':
+            case ':':
+            case ',':
+                masks.operators |= bit;
+                break;
+            default:
+                if (static_cast<unsigned char>(block[i]) >= 0x80) {
+                    masks.non_ascii |= bit;
+                }
+        }
+    }
+    return masks;
+}
+#endif
+
+// Байты, перед которыми стоит нечётная серия обратных косых черт, то есть заэкранированные.
+// Сложение находит концы серий без цикла по битам; перенос из старшего бита переходит в следующий блок.
+uint64_t FindEscaped(uint64_t backslash, uint64_t& prev_escaped) {
+    constexpr uint64_t EVEN_BITS = 0x5555555555555555ULL;
+    constexpr uint64_t ODD_BITS = ~EVEN_BITS;
+    // Первая черта блока, заэкранированная чертой из прошлого блока, не начинает серию
+    backslash &= ~prev_escaped;
+    const uint64_t starts = backslash & ~(backslash << 1);
+    const uint64_t even_starts = starts & EVEN_BITS;
+    const uint64_t odd_starts = starts & ODD_BITS;
+    const uint64_t even_carries = backslash + even_starts;
+    uint64_t odd_carries;
+    const bool ends_odd = __builtin_add_overflow(backslash, odd_starts, &odd_carries);
+    const uint64_t even_ends = even_carries & ~backslash & ODD_BITS;
+    const uint64_t odd_ends = odd_carries & ~backslash & EVEN_BITS;
+    const uint64_t escaped = even_ends | odd_ends | prev_escaped;
+    prev_escaped = ends_odd ? 1 : 0;
+    return escaped;
+}
+
+// Ведущий байт UTF-8: сколько байтов продолжения он ждёт и границы первого из них.
+// false для байта, с которого символ начинаться не может
+bool StartUtf8(uint8_t byte, uint32_t& remaining, uint8_t& lower, uint8_t& upper) {
+    if (byte < 0x80) {
+        return true;
+    }
+    else if (byte >= 0xC2 && byte <= 0xDF) {
+        remaining = 1;
+    }
+    else if (byte >= 0xE0 && byte <= 0xEF) {
+        // Без слишком длинных записей и без суррогатов
+        remaining = 2;
+        lower = byte == 0xE0 ? 0xA0 : 0x80;
+        upper = byte == 0xED ? 0x9F : 0xBF;
+    }
+    else if (byte >= 0xF0 && byte <= 0xF4) {
+        // Не больше U+10FFFF
+        remaining = 3;
+        lower = byte == 0xF0 ? 0x90 : 0x80;
+        upper = byte == 0xF4 ? 0x8F : 0xBF;
+    }
+    else {
+        return false;
+    }
+    return true;
+}
+
+// Бит i - xor битов 0..i: единицы от открывающей кавычки до закрывающей, не включая её
+uint64_t PrefixXor(uint64_t bits) {
+    bits ^= bits << 1;
+    bits ^= bits << 2;
+    bits ^= bits << 4;
+    bits ^= bits << 8;
+    bits ^= bits << 16;
+    bits ^= bits << 32;
+    return bits;
+}
+
+
+}  // namespace
+
+// В блоке не больше 64 позиций, и ещё 8 - запас для записи без ветвлений
+StructuralScanner::StructuralScanner(string_view text)
+    : text_(text)
+    , positions_(BATCH_BLOCKS * BLOCK_SIZE + 8)
+    , has_avx2_(cpu::HasAvx2()) {
+}
+
+// Последний блок всегда дополняется пробелами, даже пустой: так незаконченная
+// последовательность UTF-8 в конце текста тоже находится
+bool StructuralScanner::ScanBatch() {
+    while (true) {
+        if (error_ != nullptr) {
+            throw ParsingError(error_);
+        }
+        if (scanned_ > text_.size()) {
+            return false;
+        }
+        ScanBlocks();
+        if (count_ != 0) {
+            return true;
+        }
+    }
+}
+
+void StructuralScanner::ScanBlocks() {
+    batch_begin_ = scanned_;
+    count_ = 0;
+    index_ = 0;
+    for (size_t blocks = 0; blocks < BATCH_BLOCKS && scanned_ <= text_.size() && error_ == nullptr; ++blocks) {
+        if (scanned_ != 0 && scanned_ + BLOCK_SIZE <= text_.size()) {
+            ScanBlock(text_.data() + scanned_, scanned_);
+            scanned_ += BLOCK_SIZE;
+            continue;
+        }
+        // Перед блоком - предыдущие байты текста, чтобы проверка UTF-8 могла заглянуть назад
+        char padded[2 * BLOCK_SIZE];
+        memset(padded, ' ', sizeof(padded));
+        const size_t before = min(scanned_, BLOCK_SIZE);
+        const size_t size = min(text_.size() - scanned_, BLOCK_SIZE);
+        memcpy(padded + BLOCK_SIZE - before, text_.data() + scanned_ - before, before);
+        memcpy(padded + BLOCK_SIZE, text_.data() + scanned_, size);
+        ScanBlock(padded + BLOCK_SIZE, scanned_);
+        scanned_ += size == BLOCK_SIZE ? BLOCK_SIZE : BLOCK_SIZE + 1;
+    }
+}
+
+void StructuralScanner::ScanBlock(const char* block, size_t position) {
+#if defined(TRANSPORT_CATALOGUE_RUNTIME_AVX2)
+    uint64_t utf8_errors = 0;
+    const BlockMasks masks = has_avx2_ ? scanner_kernel::ClassifyAvx2(block, utf8_errors) : Classify(block);
+#else
+    const BlockMasks masks = Classify(block);
+#endif
+
+    const uint64_t escaped = FindEscaped(masks.backslash, prev_escaped_);
+    const uint64_t quotes = masks.quote & ~escaped;
+    const uint64_t in_string = PrefixXor(quotes) ^ prev_in_string_;
+    prev_in_string_ = static_cast<uint64_t>(static_cast<int64_t>(in_string) >> 63);
+    const uint64_t scalar = ~(masks.whitespace | masks.operators | quotes | in_string);
+    const uint64_t scalar_starts = scalar & ~((scalar << 1) | prev_scalar_);
+    prev_scalar_ = scalar >> 63;
+    uint64_t tokens = (masks.operators & ~in_string) | quotes | scalar_starts;
+
+    // Ошибка выдаётся, только когда разбор дойдёт до неё: мусор после документа не мешает
+    size_t error_index = BLOCK_SIZE;
+#if defined(TRANSPORT_CATALOGUE_RUNTIME_AVX2)
+    // Векторная проверка только находит ошибку, а её место определяет та же проверка по байтам,
+    // что и без AVX2, поэтому ошибки во всех сборках одинаковые
+    if (has_avx2_) {
+        if (utf8_errors != 0) {
+            RestoreUtf8State(block);
+            error_index = CheckUtf8(block, masks.non_ascii);
+        }
+    }
+    else
+#endif
+    error_index = CheckUtf8(block, masks.non_ascii);
+    if (error_index == BLOCK_SIZE && (masks.non_ascii >> (BLOCK_SIZE - 3)) != 0) {
+        error_index = CheckUtf8Tail(block, position);
+    }
+    if (error_index != BLOCK_SIZE) {
+        error_ = "Invalid UTF-8";
+    }
+    // Строковый литерал внутри JSON не может прерываться символами \r или \n
+    if (const uint64_t newlines = masks.newline & in_string; newlines != 0 && static_cast<size_t>(countr_zero(newlines)) < error_index) {
+        error_index = countr_zero(newlines);
+        error_ = "Unexpected end of line";
+    }
+    if (error_index != BLOCK_SIZE) {
+        tokens &= (uint64_t{1} << error_index) - 1;
+    }
+    // Позиции пишутся по восемь без ветвлений, лишние затрутся позициями следующего блока
+    uint32_t* output = positions_.data() + count_;
+    const uint32_t offset = static_cast<uint32_t>(position - batch_begin_);
+    const int count = popcount(tokens);
+    for (int i = 0; i < count; i += 8) {
+        for (int j = 0; j < 8; ++j) {
+            output[i + j] = offset + countr_zero(tokens);
+            tokens &= tokens - 1;
+        }
+    }
+    count_ += count;
+}
+
+// Номер ведущего байта первого неправильного символа UTF-8 в блоке или BLOCK_SIZE.
+// Символ, начатый в конце прошлого блока, уже проверен CheckUtf8Tail.
+size_t StructuralScanner::CheckUtf8(const char* block, uint64_t non_ascii) {
+    if (non_ascii == 0 && utf8_remaining_ == 0) {
+        return BLOCK_SIZE;
+    }
+    // Байты по одному, начиная с первого не-ASCII или с продолжения символа из прошлого блока
+    for (size_t i = utf8_remaining_ != 0 ? 0 : countr_zero(non_ascii); i < BLOCK_SIZE; ++i) {
+        const auto byte = static_cast<uint8_t>(block[i]);
+        if (utf8_remaining_ != 0) {
+            if (byte < utf8_lower_ || byte > utf8_upper_) {
+                // Назад через уже принятые байты продолжения к ведущему байту
+                size_t lead = i;
+                while (lead > 0 && (static_cast<uint8_t>(block[lead - 1]) & 0xC0) == 0x80) {
+                    --lead;
+                }
+                return lead > 0 ? lead - 1 : 0;
+            }
+            utf8_lower_ = 0x80;
+            utf8_upper_ = 0xBF;
+            --utf8_remaining_;
+        }
+        // Те же правила, что в StartUtf8: вызов с состоянием по ссылкам в этом цикле заметно медленнее
+        else if (byte < 0x80) {
+            continue;
+        }
+        else if (byte >= 0xC2 && byte <= 0xDF) {
+            utf8_remaining_ = 1;
+        }
+        else if (byte >= 0xE0 && byte <= 0xEF) {
+            // Без слишком длинных записей и без суррогатов
+            utf8_remaining_ = 2;
+            utf8_lower_ = byte == 0xE0 ? 0xA0 : 0x80;
+            utf8_upper_ = byte == 0xED ? 0x9F : 0xBF;
+        }
+        else if (byte >= 0xF0 && byte <= 0xF4) {
+            // Не больше U+10FFFF
+            utf8_remaining_ = 3;
+            utf8_lower_ = byte == 0xF0 ? 0x90 : 0x80;
+            utf8_upper_ = byte == 0xF4 ? 0x8F : 0xBF;
+        }
+        else {
+            return i;
+        }
+    }
+    return BLOCK_SIZE;
+}
+
+#if defined(TRANSPORT_CATALOGUE_RUNTIME_AVX2)
+// Векторная проверка не ведёт состояние по байтам: оно восстанавливается по трём байтам перед блоком,
+// которые уже проверены и составляют правильный UTF-8
+void StructuralScanner::RestoreUtf8State(const char* block) {
+    utf8_remaining_ = 0;
+    utf8_lower_ = 0x80;
+    utf8_upper_ = 0xBF;
+    for (size_t back = 1; back <= 3; ++back) {
+        const auto byte = static_cast<uint8_t>(block[-static_cast<ptrdiff_t>(back)]);
+        if (byte < 0xC0) {
+            if (byte < 0x80) {
+                return;
+            }
+            continue;
+        }
+        StartUtf8(byte, utf8_remaining_, utf8_lower_, utf8_upper_);
+        // Особые границы действуют только для байта сразу за ведущим
+        if (back != 1) {
+            utf8_lower_ = 0x80;
+            utf8_upper_ = 0xBF;
+        }
+        utf8_remaining_ = utf8_remaining_ >= back ? utf8_remaining_ - static_cast<uint32_t>(back - 1) : 0;
+        return;
+    }
+}
+#endif
+
+// Ошибка в символе из последних байтов блока видна только в следующем блоке, когда позиции этого
+// уже выданы. Поэтому такой символ проверяется здесь по байтам после блока, чтобы позиции
+// маскировались с его ведущего байта.
+size_t StructuralScanner::CheckUtf8Tail(const char* block, size_t position) const {
+    for (size_t back = 1; back <= 3; ++back) {
+        const size_t lead = BLOCK_SIZE - back;
+        const auto byte = static_cast<uint8_t>(block[lead]);
+        if (byte < 0xC0) {
+            if (byte < 0x80) {
+                return BLOCK_SIZE;
+            }
+            continue;
+        }
+        uint32_t remaining = 0;
+        uint8_t lower = 0x80;
+        uint8_t upper = 0xBF;
+        if (!StartUtf8(byte, remaining, lower, upper)) {
+            return lead;
+        }
+        // Байты внутри блока уже проверены, за концом текста - пробелы, как в последнем блоке
+        for (size_t i = lead + 1; i <= lead + remaining; ++i) {
+            if (i < BLOCK_SIZE) {
+                continue;
+            }
+            const size_t next = position + i;
+            const auto continuation = static_cast<uint8_t>(next < text_.size() ? text_[next] : ' ');
+            if (continuation < (i == lead + 1 ? lower : 0x80) || continuation > (i == lead + 1 ? upper : 0xBF)) {
+                return lead;
+            }
+        }
+        return BLOCK_SIZE;
+    }
+    return BLOCK_SIZE;
+}
+
+} // namespace json
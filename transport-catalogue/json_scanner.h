@@ -0,0 +1,70 @@
+#pragma once
+
+#include "cpu_features.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace json {
+
+// Первый проход разбора: позиции значимых символов текста. Это { } [ ] : , вне строк,
+// незаэкранированные кавычки (и открывающие, и закрывающие) и первые символы чисел и литералов.
+// Текст обрабатывается блоками по 64 байта: для блока строятся битовые маски символов
+// (AVX2, если его поддерживает процессор, иначе SSE2; отключается макросом TRANSPORT_CATALOGUE_NO_SIMD),
+// из них маска строк и позиции. Попутно проверяется, что текст - правильный UTF-8
+// и что строки не прерываются переводом строки; при ошибке бросается ParsingError.
+// Позиции выдаются по запросу второго прохода и находятся пачками, поэтому память под них не растёт с текстом.
+// Ошибка выдаётся, когда второй проход запросит позицию после неё.
+class StructuralScanner {
+public:
+    static constexpr size_t END = SIZE_MAX;
+
+    explicit StructuralScanner(std::string_view text);
+
+    // Позиция следующего значимого символа или END
+    size_t Peek() {
+        if (index_ == count_ && !ScanBatch()) {
+            return END;
+        }
+        return batch_begin_ + positions_[index_];
+    }
+    // То же со сдвигом к следующему
+    size_t Next() {
+        const size_t position = Peek();
+        if (position != END) {
+            ++index_;
+        }
+        return position;
+    }
+
+private:
+    bool ScanBatch(); // false в конце текста
+    void ScanBlocks();
+    void ScanBlock(const char* block, size_t position);
+    size_t CheckUtf8(const char* block, uint64_t non_ascii);
+    size_t CheckUtf8Tail(const char* block, size_t position) const;
+#if defined(TRANSPORT_CATALOGUE_RUNTIME_AVX2)
+    void RestoreUtf8State(const char* block);
+#endif
+
+    std::string_view text_;
+    size_t scanned_ = 0; // Байты, для которых позиции уже найдены
+    size_t batch_begin_ = 0;
+    std::vector<uint32_t> positions_; // Смещения от batch_begin_
+    size_t count_ = 0;
+    size_t index_ = 0;
+    const char* error_ = nullptr;
+    bool has_avx2_ = false; // Маски и проверка UTF-8 считаются ядром из json_scanner_avx2.cpp
+
+    // Состояние на границе блоков
+    uint64_t prev_escaped_ = 0; // 1, если блок кончился нечётной серией обратных косых черт
+    uint64_t prev_in_string_ = 0; // Все единицы, если блок кончился внутри строки
+    uint64_t prev_scalar_ = 0; // 1, если последний байт блока - часть числа или литерала
+    uint32_t utf8_remaining_ = 0; // Сколько ещё байтов продолжения ждёт последний символ
+    uint8_t utf8_lower_ = 0x80; // Допустимые границы следующего байта продолжения
+    uint8_t utf8_upper_ = 0xBF;
+};
+
+} // namespace json
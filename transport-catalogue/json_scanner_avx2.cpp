@@ -0,0 +1,131 @@
+// Маски блока для json_scanner.cpp, собранные с AVX2. Сканер вызывает их, только если процессор поддерживает AVX2
+#include "cpu_features.h"
+
+#if defined(TRANSPORT_CATALOGUE_RUNTIME_AVX2)
+
+// Стандартные заголовки подключаются до #pragma, чтобы их inline-функции не получили инструкции AVX2
+#include <cstddef>
+#include <cstdint>
+#include <immintrin.h>
+
+#pragma GCC target("avx2")
+
+#include "json_scanner_kernel.h"
+
+namespace json::scanner_kernel {
+
+namespace {
+
+uint64_t ToMask(__m256i low, __m256i high) {
+    return static_cast<uint32_t>(_mm256_movemask_epi8(low)) | (static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(high))) << 32);
+}
+
+uint64_t Equal(__m256i low, __m256i high, char c) {
+    const __m256i value = _mm256_set1_epi8(c);
+    return ToMask(_mm256_cmpeq_epi8(low, value), _mm256_cmpeq_epi8(high, value));
+}
+
+BlockMasks Classify(const char* block) {
+    const __m256i low = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+    const __m256i high = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + 32));
+    // [ и { отличаются только битом 0x20, как и ] и }
+    const __m256i case_bit = _mm256_set1_epi8(0x20);
+    const __m256i low_folded = _mm256_or_si256(low, case_bit);
+    const __m256i high_folded = _mm256_or_si256(high, case_bit);
+    BlockMasks masks;
+    masks.backslash = Equal(low, high, '\\');
+    masks.quote = Equal(low, high, '"');
+    masks.newline = Equal(low, high, '\n') | Equal(low, high, '\r');
+    masks.whitespace = masks.newline | Equal(low, high, ' ') | Equal(low, high, '\t');
+    masks.operators = Equal(low_folded, high_folded, '{') | Equal(low_folded, high_folded, '}') | Equal(low, high, ':') | Equal(low, high, ',');
+    masks.non_ascii = ToMask(low, high);
+    return masks;
+}
+
+// Ошибки UTF-8 по парам соседних байтов и по длине многобайтных символов, алгоритм из
+// J. Keiser, D. Lemire "Validating UTF-8 In Less Than One Instruction Per Byte".
+// Каждая таблица по половине байта отмечает, каким ошибкам эта половина не противоречит,
+// ошибка есть, если на её бит согласны все три таблицы.
+constexpr uint8_t TOO_SHORT = 1 << 0; // Ведущий байт без продолжения
+constexpr uint8_t TOO_LONG = 1 << 1; // Продолжение после ASCII
+constexpr uint8_t OVERLONG_3 = 1 << 2;
+constexpr uint8_t TOO_LARGE = 1 << 3; // Больше U+10FFFF
+constexpr uint8_t SURROGATE = 1 << 4;
+constexpr uint8_t OVERLONG_2 = 1 << 5;
+constexpr uint8_t TOO_LARGE_1000 = 1 << 6;
+constexpr uint8_t OVERLONG_4 = 1 << 6;
+constexpr uint8_t TWO_CONTS = 1 << 7; // Два продолжения подряд; допустимы только в 3- и 4-байтных символах
+constexpr uint8_t CARRY = TOO_SHORT | TOO_LONG | TWO_CONTS;
+
+constexpr uint8_t BYTE_1_HIGH[16] = {
+    TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+    TWO_CONTS, TWO_CONTS, TWO_CONTS, TWO_CONTS,
+    TOO_SHORT | OVERLONG_2,
+    TOO_SHORT,
+    TOO_SHORT | OVERLONG_3 | SURROGATE,
+    TOO_SHORT | TOO_LARGE | TOO_LARGE_1000 | OVERLONG_4};
+constexpr uint8_t BYTE_1_LOW[16] = {
+    CARRY | OVERLONG_3 | OVERLONG_2 | OVERLONG_4,
+    CARRY | OVERLONG_2,
+    CARRY,
+    CARRY,
+    CARRY | TOO_LARGE,
+    CARRY | TOO_LARGE | TOO_LARGE_1000,
+    CARRY | TOO_LARGE | TOO_LARGE_1000,
+    CARRY | TOO_LARGE | TOO_LARGE_1000,
+    CARRY | TOO_LARGE | TOO_LARGE_1000,
+    CARRY | TOO_LARGE | TOO_LARGE_1000,
+    CARRY | TOO_LARGE | TOO_LARGE_1000,
+    CARRY | TOO_LARGE | TOO_LARGE_1000,
+    CARRY | TOO_LARGE | TOO_LARGE_1000,
+    CARRY | TOO_LARGE | TOO_LARGE_1000 | SURROGATE,
+    CARRY | TOO_LARGE | TOO_LARGE_1000,
+    CARRY | TOO_LARGE | TOO_LARGE_1000};
+constexpr uint8_t BYTE_2_HIGH[16] = {
+    TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+    TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE_1000 | OVERLONG_4,
+    TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE,
+    TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+    TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+    TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT};
+
+__m256i Lookup(const uint8_t (&table)[16], __m256i index) {
+    const __m256i lanes = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(table)));
+    return _mm256_shuffle_epi8(lanes, index);
+}
+
+__m256i FindUtf8Errors(const char* data) {
+    const __m256i input = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data));
+    const __m256i prev1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data - 1));
+    const __m256i prev2 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data - 2));
+    const __m256i prev3 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data - 3));
+    const __m256i low_nibble = _mm256_set1_epi8(0x0F);
+    const __m256i special_cases = _mm256_and_si256(
+        _mm256_and_si256(Lookup(BYTE_1_HIGH, _mm256_and_si256(_mm256_srli_epi16(prev1, 4), low_nibble)),
+                         Lookup(BYTE_1_LOW, _mm256_and_si256(prev1, low_nibble))),
+        Lookup(BYTE_2_HIGH, _mm256_and_si256(_mm256_srli_epi16(input, 4), low_nibble)));
+    // Третий и четвёртый байты символа должны быть продолжениями, и только они могут идти вторым продолжением подряд
+    const __m256i is_third_byte = _mm256_subs_epu8(prev2, _mm256_set1_epi8(static_cast<char>(0xE0 - 0x80)));
+    const __m256i is_fourth_byte = _mm256_subs_epu8(prev3, _mm256_set1_epi8(static_cast<char>(0xF0 - 0x80)));
+    const __m256i must_be_continuation = _mm256_and_si256(_mm256_or_si256(is_third_byte, is_fourth_byte), _mm256_set1_epi8(static_cast<char>(0x80)));
+    return _mm256_xor_si256(must_be_continuation, special_cases);
+}
+
+// Маска байтов блока с ошибками; три байта перед блоком тоже должны быть доступны
+uint64_t FindUtf8ErrorsInBlock(const char* block) {
+    const __m256i zero = _mm256_setzero_si256();
+    return ~ToMask(_mm256_cmpeq_epi8(FindUtf8Errors(block), zero), _mm256_cmpeq_epi8(FindUtf8Errors(block + 32), zero));
+}
+
+}  // namespace
+
+BlockMasks ClassifyAvx2(const char* block, uint64_t& utf8_errors) {
+    const BlockMasks masks = Classify(block);
+    // ASCII-блок после ASCII-байтов проверять не нужно
+    utf8_errors = masks.non_ascii == 0 && ((block[-1] | block[-2] | block[-3]) & 0x80) == 0 ? 0 : FindUtf8ErrorsInBlock(block);
+    return masks;
+}
+
+} // namespace json::scanner_kernel
+
+#endif
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "cpu_features.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace json::scanner_kernel {
+
+constexpr size_t BLOCK_SIZE = 64;
+
+// Бит i маски соответствует байту i блока
+struct BlockMasks {
+    uint64_t backslash = 0;
+    uint64_t quote = 0;
+    uint64_t whitespace = 0;
+    uint64_t newline = 0;
+    uint64_t operators = 0; // { } [ ] : ,
+    uint64_t non_ascii = 0;
+};
+
+#if defined(TRANSPORT_CATALOGUE_RUNTIME_AVX2)
+// Маски блока на AVX2 из json_scanner_avx2.cpp, вызывать только при cpu::HasAvx2().
+// utf8_errors - байты, на которых векторная проверка нашла ошибку UTF-8;
+// три байта перед блоком тоже должны быть доступны
+BlockMasks ClassifyAvx2(const char* block, uint64_t& utf8_errors);
+#endif
+
+} // namespace json::scanner_kernel
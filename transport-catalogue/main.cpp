@@ -3,17 +3,120 @@
 #include "map_renderer.h"
 #include "graph.h"
 #include "domain.h"
+#include "serialization.h"
+#include "catalogue_image.h"
+#include "catalogue_versions.h"
+#include "sharded_catalogue.h"
+#include "tenant_registry.h"
+#include "thread_pool.h"
 
 #include <chrono>
 #include <iostream>
+#include <optional>
 #include <string>
+#include <string_view>
 
 using namespace std;
 
-int main() {
+//Запуск: transport_catalogue [--threads N] [--shards N] [--load-snapshot FILE] [--save-snapshot FILE]
+//                            [--save-image FILE] [--image FILE] [--input FILE]
+//При --threads N > 1 запросы stat_requests обрабатываются параллельно.
+//При --shards N > 1 base_requests делятся по долготе между N процессами-обработчиками;
+//со снимками и образом --shards не сочетается, каталог тогда загружается в один процесс.
+//Шардируются только запросы Bus и Stop; для остальных запускается отдельный процесс со всей сетью.
+//--load-snapshot берёт каталог и настройки отрисовки из снимка вместо base_requests,
+//--save-snapshot сохраняет загруженный каталог в снимок.
+//--save-image FILE сохраняет образ каталога для отображения в память,
+//--image FILE отвечает на запросы Bus и Stop по образу, не загружая каталог.
+//--input FILE читает запросы из файла, отображённого в память, вместо стандартного ввода.
+//--routes-encoding delta хранит остановки маршрутов сжатыми (по умолчанию plain).
+//Запрос {"type": "Update", "base_requests": [...]} в stat_requests добавляет или заменяет остановки и маршруты,
+//а {"type": "RemoveBus"} и {"type": "RemoveStop"} с именем в его base_requests удаляют их:
+//следующие запросы отвечаются по новой версии каталога (кроме режимов --shards, --image и "tenants").
+//Если во входных данных есть массив "tenants", каталоги всех городов загружаются в один процесс.
+int main(int argc, char* argv[]) {
+    size_t threads_count = 1;
+    size_t shards_count = 1;
+    std::string load_path;
+    std::string save_path;
+    std::string image_path;
+    std::string save_image_path;
+    std::string input_path;
+    auto routes_encoding = transport_catalogue::StopSequencePool::Encoding::Plain;
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (argv[i] == "--threads"sv) {
+            threads_count = std::stoul(argv[++i]);
+        }
+        else if (argv[i] == "--shards"sv) {
+            shards_count = std::stoul(argv[++i]);
+        }
+        else if (argv[i] == "--load-snapshot"sv) {
+            load_path = argv[++i];
+        }
+        else if (argv[i] == "--save-snapshot"sv) {
+            save_path = argv[++i];
+        }
+        else if (argv[i] == "--image"sv) {
+            image_path = argv[++i];
+        }
+        else if (argv[i] == "--save-image"sv) {
+            save_image_path = argv[++i];
+        }
+        else if (argv[i] == "--input"sv) {
+            input_path = argv[++i];
+        }
+        else if (argv[i] == "--routes-encoding"sv) {
+            if (argv[++i] == "delta"sv) {
+                routes_encoding = transport_catalogue::StopSequencePool::Encoding::Delta;
+            }
+        }
+    }
+    if (!image_path.empty()) {
+        const transport_catalogue::CatalogueImage catalogue_image(image_path);
+        json::Document catalogue_data{input_path.empty() ? json::Load(std::cin) : json::LoadFile(input_path)};
+        json::Print(transport_catalogue::ParseAndMakeAnswers(catalogue_image, catalogue_data.GetRoot()), std::cout);
+        return 0;
+    }
+    json::Document catalogue_data{input_path.empty() ? json::Load(std::cin) : json::LoadFile(input_path)};
+    if (catalogue_data.GetRoot().AsMap().contains("tenants")) {
+        transport_catalogue::ThreadPool pool(threads_count);
+        transport_catalogue::TenantRegistry registry(pool);
+        json::Print(registry.LoadAndMakeAnswers(catalogue_data.GetRoot()), std::cout);
+        return 0;
+    }
+    //Шардам каталог в главном процессе не нужен: обработчики загружают свои доли base_requests сами
+    if (shards_count > 1 && load_path.empty() && save_path.empty() && save_image_path.empty()
+        && catalogue_data.GetRoot().AsMap().contains("stat_requests")) {
+        transport_catalogue::ShardedCatalogue sharded_catalogue(catalogue_data.GetRoot(), shards_count);
+        json::Print(sharded_catalogue.ParseAndMakeAnswers(catalogue_data.GetRoot()), std::cout);
+        return 0;
+    }
     transport_catalogue::TransportCatalogue catalogue;
-    json::Document catalogue_data{json::Load(std::cin)};
-    transport_catalogue::LoadCatalogueFromJson(catalogue, catalogue_data.GetRoot());
-    json::Document answer_data{transport_catalogue::ParseAndMakeAnswers(catalogue, catalogue_data.GetRoot())};
+    std::optional<transport_catalogue::RenderSettings> render_settings;
+    if (!load_path.empty()) {
+        render_settings = transport_catalogue::LoadCatalogue(load_path, catalogue);
+    }
+    if (load_path.empty()) {
+        transport_catalogue::LoadCatalogueFromJson(catalogue, catalogue_data.GetRoot());
+        render_settings = transport_catalogue::LoadRenderSettingsFromJson(catalogue_data.GetRoot());
+    }
+    catalogue.SetStopsEncoding(routes_encoding);
+    if (!save_path.empty()) {
+        transport_catalogue::SaveCatalogue(save_path, catalogue, render_settings);
+    }
+    if (!save_image_path.empty()) {
+        transport_catalogue::SaveCatalogueImage(save_image_path, catalogue);
+    }
+    if (!catalogue_data.GetRoot().AsMap().contains("stat_requests")) {
+        return 0;
+    }
+    //Запросы Update публикуют новые версии каталога, остальные запросы читают текущую
+    transport_catalogue::CatalogueVersions versions(std::move(catalogue));
+    if (threads_count > 1) {
+        transport_catalogue::ThreadPool pool(threads_count);
+        json::Print(transport_catalogue::ParseAndMakeAnswers(versions, render_settings, catalogue_data.GetRoot(), pool), std::cout);
+        return 0;
+    }
+    json::Document answer_data{transport_catalogue::ParseAndMakeAnswers(versions, render_settings, catalogue_data.GetRoot())};
     json::Print(answer_data, std::cout);;
-}
\ No newline at end of file
+}
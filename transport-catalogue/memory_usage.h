@@ -0,0 +1,79 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <deque>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace memory {
+
+//Память, занятая одной структурой. Байты считаются по устройству контейнеров libstdc++
+//и блокам malloc из glibc, поэтому это оценка, пригодная для прогноза и сравнения версий.
+struct Usage {
+    std::string name;
+    size_t bytes = 0;
+    size_t elements = 0;
+    std::optional<size_t> buckets = std::nullopt; //Только для хеш-таблиц
+    std::optional<double> load_factor = std::nullopt;
+};
+
+using Report = std::vector<Usage>;
+
+//Размер блока, который malloc отдаёт под запрос size байт: заголовок и выравнивание на 16
+inline size_t AllocationSize(size_t size) {
+    if (size == 0) {
+        return 0;
+    }
+    return std::max<size_t>(32, (size + sizeof(size_t) + 15) / 16 * 16);
+}
+
+template <typename T, typename Allocator>
+size_t VectorBytes(const std::vector<T, Allocator>& vector) {
+    return AllocationSize(vector.capacity() * sizeof(T));
+}
+
+template <typename Allocator>
+size_t StringBytes(const std::basic_string<char, std::char_traits<char>, Allocator>& string) {
+    //Короткие строки хранятся внутри объекта
+    return string.capacity() > 15 ? AllocationSize(string.capacity() + 1) : 0;
+}
+
+//Дек хранит элементы в блоках по 512 байт и массив указателей на блоки
+template <typename T>
+size_t DequeBytes(const std::deque<T>& deque) {
+    constexpr size_t block_elements = sizeof(T) < 512 ? 512 / sizeof(T) : 1;
+    const size_t blocks = deque.size() / block_elements + 1;
+    const size_t map_size = std::max<size_t>(8, blocks + 2);
+    return blocks * AllocationSize(block_elements * sizeof(T)) + AllocationSize(map_size * sizeof(T*));
+}
+
+//Узел хеш-таблицы: указатель на следующий узел, значение и хеш ключа.
+//libstdc++ не хранит хеш для целых и указателей, он вычисляется заново.
+template <typename Table>
+size_t HashTableBytes(const Table& table) {
+    using Key = typename Table::key_type;
+    constexpr bool is_hash_cached = !std::is_integral_v<Key> && !std::is_pointer_v<Key>;
+    constexpr size_t node_size = sizeof(void*) + sizeof(typename Table::value_type) + (is_hash_cached ? sizeof(size_t) : 0);
+    //Таблица из одной корзины использует корзину внутри самого объекта
+    const size_t buckets_bytes = table.bucket_count() > 1 ? AllocationSize(table.bucket_count() * sizeof(void*)) : 0;
+    return table.size() * AllocationSize(node_size) + buckets_bytes;
+}
+
+template <typename Table>
+Usage HashTableUsage(std::string name, const Table& table) {
+    Usage usage{std::move(name), HashTableBytes(table), table.size()};
+    usage.buckets = table.bucket_count();
+    usage.load_factor = table.load_factor();
+    return usage;
+}
+
+template <typename T>
+Usage VectorUsage(std::string name, const std::vector<T>& vector) {
+    return {std::move(name), VectorBytes(vector), vector.size()};
+}
+
+} //memory
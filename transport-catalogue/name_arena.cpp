@@ -0,0 +1,84 @@
+#include "name_arena.h"
+
+#include <algorithm>
+#include <mutex>
+
+namespace transport_catalogue {
+
+char* NameArena::Allocate(size_t size) {
+    //Длинное имя получает собственный блок, чтобы не терять остаток текущего
+    if (size > BLOCK_SIZE / 4) {
+        auto block = std::make_unique<char[]>(size);
+        char* result = block.get();
+        blocks_.push_back(std::move(block));
+        return result;
+    }
+    if (size > block_free_) {
+        blocks_.push_back(std::make_unique<char[]>(BLOCK_SIZE));
+        block_current_ = blocks_.back().get();
+        block_free_ = BLOCK_SIZE;
+    }
+    char* result = block_current_;
+    block_current_ += size;
+    block_free_ -= size;
+    return result;
+}
+
+NameId NameArena::Intern(std::string_view name) {
+    std::unique_lock lock(mutex_);
+    if (auto it = ids_.find(name); it != ids_.end()) {
+        return it->second;
+    }
+    char* data = Allocate(name.size());
+    std::copy(name.begin(), name.end(), data);
+    bytes_used_ += name.size();
+    const NameId id = static_cast<NameId>(names_.size());
+    names_.push_back({data, name.size()});
+    ids_.emplace(names_.back(), id);
+    return id;
+}
+
+std::optional<NameId> NameArena::Find(std::string_view name) const {
+    std::shared_lock lock(mutex_);
+    if (auto it = ids_.find(name); it != ids_.end()) {
+        return it->second;
+    }
+    return std::nullopt;
+}
+
+std::string_view NameArena::Get(NameId id) const {
+    std::shared_lock lock(mutex_);
+    return names_.at(id);
+}
+
+size_t NameArena::Size() const {
+    std::shared_lock lock(mutex_);
+    return names_.size();
+}
+
+size_t NameArena::GetBytesUsed() const {
+    std::shared_lock lock(mutex_);
+    return bytes_used_;
+}
+
+memory::Report NameArena::GetMemoryUsage() const {
+    std::shared_lock lock(mutex_);
+    size_t blocks_bytes = memory::VectorBytes(blocks_);
+    //Все блоки, кроме выделенных под длинные имена, имеют размер BLOCK_SIZE
+    size_t long_names_bytes = 0;
+    size_t long_names_count = 0;
+    for (std::string_view name : names_) {
+        if (name.size() > BLOCK_SIZE / 4) {
+            long_names_bytes += memory::AllocationSize(name.size());
+            ++long_names_count;
+        }
+    }
+    blocks_bytes += (blocks_.size() - long_names_count) * memory::AllocationSize(BLOCK_SIZE) + long_names_bytes;
+    return {
+        {"blocks", blocks_bytes, blocks_.size()},
+        memory::VectorUsage("names", names_),
+        memory::HashTableUsage("ids", ids_)
+    };
+}
+
+} //transport_catalogue
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "memory_usage.h"
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <shared_mutex>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace transport_catalogue {
+
+using NameId = uint32_t;
+
+//Хранилище уникальных имён остановок и маршрутов.
+//Байты имён лежат подряд в крупных блоках, которые не перемещаются,
+//поэтому string_view на имя остаются действительными всё время жизни арены.
+//Арену можно пополнять, пока другие потоки читают из неё (например, общую для версий каталога).
+class NameArena {
+public:
+    NameId Intern(std::string_view name);
+    std::optional<NameId> Find(std::string_view name) const;
+    std::string_view Get(NameId id) const;
+    size_t Size() const;
+    size_t GetBytesUsed() const;
+    memory::Report GetMemoryUsage() const; //Блоки с байтами имён, список имён и таблица поиска
+
+private:
+    static constexpr size_t BLOCK_SIZE = 64 * 1024;
+
+    char* Allocate(size_t size);
+
+    mutable std::shared_mutex mutex_;
+    std::vector<std::unique_ptr<char[]>> blocks_;
+    char* block_current_ = nullptr;
+    size_t block_free_ = 0;
+    size_t bytes_used_ = 0;
+    std::vector<std::string_view> names_;
+    std::unordered_map<std::string_view, NameId> ids_;
+};
+
+} //transport_catalogue
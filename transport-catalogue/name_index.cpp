@@ -0,0 +1,162 @@
+#include "name_index.h"
+#include "copy_on_write.h"
+
+#include <algorithm>
+#include <iterator>
+#include <tuple>
+
+namespace transport_catalogue {
+
+std::string FoldName(std::string_view name) {
+    std::string result;
+    result.reserve(name.size());
+    for (size_t i = 0; i < name.size(); ++i) {
+        const unsigned char byte = name[i];
+        if (byte >= 'A' && byte <= 'Z') {
+            result.push_back(static_cast<char>(byte - 'A' + 'a'));
+            continue;
+        }
+        //Кириллица U+0400..U+045F кодируется двумя байтами D0 или D1 и 80..BF
+        if ((byte == 0xD0 || byte == 0xD1) && i + 1 < name.size()) {
+            const unsigned char next = name[i + 1];
+            if (next >= 0x80 && next <= 0xBF) {
+                const unsigned code = ((byte & 0x1F) << 6) | (next & 0x3F);
+                unsigned folded = code;
+                if (code == 0x401 || code == 0x451) { //Ё, ё
+                    folded = 0x435;
+                }
+                else if (code >= 0x410 && code <= 0x42F) { //А..Я
+                    folded = code + 0x20;
+                }
+                else if (code >= 0x400 && code <= 0x40F) { //Ѐ..Џ
+                    folded = code + 0x50;
+                }
+                result.push_back(static_cast<char>(0xC0 | (folded >> 6)));
+                result.push_back(static_cast<char>(0x80 | (folded & 0x3F)));
+                ++i;
+                continue;
+            }
+        }
+        result.push_back(static_cast<char>(byte));
+    }
+    return result;
+}
+
+bool NameIndex::Entry::operator<(const Entry& other) const {
+    return std::tie(key, name) < std::tie(other.key, other.name);
+}
+
+void NameIndex::Build(const std::vector<std::string_view>& names) {
+    std::vector<Entry> entries;
+    entries.reserve(names.size());
+    for (std::string_view name : names) {
+        entries.push_back({FoldName(name), name});
+    }
+    std::sort(entries.begin(), entries.end());
+    chunks_.clear();
+    for (size_t begin = 0; begin < entries.size(); begin += CHUNK_SIZE) {
+        const size_t end = std::min(begin + CHUNK_SIZE, entries.size());
+        chunks_.push_back(std::make_shared<Chunk>(std::make_move_iterator(entries.begin() + begin), std::make_move_iterator(entries.begin() + end)));
+    }
+    size_ = entries.size();
+}
+
+//Первый кусок, последнее имя которого не меньше entry, или последний кусок
+size_t NameIndex::FindChunk(const Entry& entry) const {
+    const auto it = std::partition_point(chunks_.begin(), chunks_.end(), [&entry](const std::shared_ptr<Chunk>& chunk) {
+        return chunk->back() < entry;
+    });
+    return std::min<size_t>(it - chunks_.begin(), chunks_.size() - 1);
+}
+
+NameIndex::Chunk& NameIndex::MutableChunk(size_t chunk) {
+    std::shared_ptr<Chunk>& data = chunks_[chunk];
+    if (!copy_on_write_detail::IsUnique(data)) {
+        data = std::make_shared<Chunk>(*data);
+    }
+    return *data;
+}
+
+//Переполненный кусок делится пополам
+void NameIndex::Insert(std::string_view name) {
+    Entry entry{FoldName(name), name};
+    ++size_;
+    if (chunks_.empty()) {
+        chunks_.push_back(std::make_shared<Chunk>(1, std::move(entry)));
+        return;
+    }
+    const size_t index = FindChunk(entry);
+    Chunk& chunk = MutableChunk(index);
+    chunk.insert(std::upper_bound(chunk.begin(), chunk.end(), entry), std::move(entry));
+    if (chunk.size() > 2 * CHUNK_SIZE) {
+        auto tail = std::make_shared<Chunk>(std::make_move_iterator(chunk.begin() + CHUNK_SIZE), std::make_move_iterator(chunk.end()));
+        chunk.erase(chunk.begin() + CHUNK_SIZE, chunk.end());
+        chunks_.insert(chunks_.begin() + index + 1, std::move(tail));
+    }
+}
+
+//Опустевший кусок удаляется
+void NameIndex::Erase(std::string_view name) {
+    if (chunks_.empty()) {
+        return;
+    }
+    const Entry entry{FoldName(name), name};
+    const size_t index = FindChunk(entry);
+    const auto it = std::lower_bound(chunks_[index]->begin(), chunks_[index]->end(), entry);
+    if (it == chunks_[index]->end() || it->name != name) {
+        return;
+    }
+    const size_t position = it - chunks_[index]->begin();
+    Chunk& chunk = MutableChunk(index);
+    chunk.erase(chunk.begin() + position);
+    --size_;
+    if (chunk.empty()) {
+        chunks_.erase(chunks_.begin() + index);
+    }
+}
+
+size_t NameIndex::Size() const {
+    return size_;
+}
+
+//Общие куски учитываются в каждой копии индекса, которая их держит
+memory::Usage NameIndex::GetMemoryUsage() const {
+    size_t bytes = memory::VectorBytes(chunks_);
+    for (const auto& chunk : chunks_) {
+        bytes += copy_on_write_detail::SharedBytes<Chunk>() + memory::VectorBytes(*chunk);
+        for (const Entry& entry : *chunk) {
+            bytes += memory::StringBytes(entry.key);
+        }
+    }
+    return {"name_index", bytes, size_};
+}
+
+std::vector<std::string_view> NameIndex::FindByPrefix(std::string_view prefix, size_t limit) const {
+    const std::string key = FoldName(prefix);
+    auto chunk = std::partition_point(chunks_.begin(), chunks_.end(), [&key](const std::shared_ptr<Chunk>& chunk) {
+        return chunk->back().key < key;
+    });
+    std::vector<std::string_view> result;
+    if (chunk == chunks_.end()) {
+        return result;
+    }
+    auto it = std::lower_bound((*chunk)->begin(), (*chunk)->end(), key, [](const Entry& entry, const std::string& key) {
+        return entry.key < key;
+    });
+    while (result.size() < limit) {
+        if (it == (*chunk)->end()) {
+            if (++chunk == chunks_.end()) {
+                break;
+            }
+            it = (*chunk)->begin();
+        }
+        if (!it->key.starts_with(key)) {
+            break;
+        }
+        result.push_back(it->name);
+        ++it;
+    }
+    return result;
+}
+
+} //transport_catalogue
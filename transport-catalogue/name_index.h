@@ -0,0 +1,51 @@
+#pragma once
+
+#include "memory_usage.h"
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace transport_catalogue {
+
+//Имя для сравнения без учёта регистра: латиница и кириллица в UTF-8 приводятся к строчным, ё - к е.
+//Остальные байты, в том числе некорректный UTF-8, не меняются.
+std::string FoldName(std::string_view name);
+
+//Имена, отсортированные по приведённому виду, для подсказок по началу имени.
+//Имена с общим началом лежат подряд, поэтому поиск - двоичный поиск и проход по соседям.
+//Упорядоченный массив разбит на куски не больше 2 * CHUNK_SIZE имён, общие у копий индекса:
+//добавление и удаление сдвигают имена одного куска и указатели на куски, а не весь массив.
+//Сами имена не копируются: string_view указывают в арену имён каталога.
+class NameIndex {
+public:
+    void Build(const std::vector<std::string_view>& names);
+    void Insert(std::string_view name);
+    void Erase(std::string_view name);
+    size_t Size() const;
+    memory::Usage GetMemoryUsage() const;
+
+    //Не больше limit имён, начинающихся с prefix без учёта регистра,
+    //по возрастанию приведённого имени, при равных - исходного
+    std::vector<std::string_view> FindByPrefix(std::string_view prefix, size_t limit) const;
+
+private:
+    static constexpr size_t CHUNK_SIZE = 256;
+
+    struct Entry {
+        std::string key; //Приведённое имя
+        std::string_view name;
+
+        bool operator<(const Entry& other) const;
+    };
+    using Chunk = std::vector<Entry>;
+
+    size_t FindChunk(const Entry& entry) const; //Кусок, в который попадает имя
+    Chunk& MutableChunk(size_t chunk);
+
+    std::vector<std::shared_ptr<Chunk>> chunks_; //Непустые куски по возрастанию имён
+    size_t size_ = 0;
+};
+
+} //transport_catalogue
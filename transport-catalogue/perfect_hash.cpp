@@ -0,0 +1,139 @@
+#include "perfect_hash.h"
+
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+
+namespace transport_catalogue {
+
+namespace {
+
+//Финализатор MurmurHash3: каждый бит ключа влияет на все биты результата
+uint64_t Mix(uint64_t key) {
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    key *= 0xc4ceb9fe1a85ec53ULL;
+    key ^= key >> 33;
+    return key;
+}
+
+//Число в диапазоне 0..range-1 без деления: старшие биты произведения
+size_t ReduceToRange(uint32_t value, size_t range) {
+    return static_cast<size_t>((static_cast<uint64_t>(value) * range) >> 32);
+}
+
+//Попыток на корзину, после которых набор строится заново с другим зерном
+constexpr uint32_t MAX_DISPLACEMENT = 1 << 22;
+constexpr int MAX_ATTEMPTS = 16;
+
+} //namespace
+
+//FNV-1a с зерном, затем перемешивание: у коротких похожих имён различаются все биты
+uint64_t PerfectHash::Hash(std::string_view key) const {
+    uint64_t hash = 0xcbf29ce484222325ULL ^ seed_;
+    for (char c : key) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 0x100000001b3ULL;
+    }
+    return Mix(hash);
+}
+
+size_t PerfectHash::GetBucket(uint64_t hash) const {
+    return ReduceToRange(static_cast<uint32_t>(hash >> 32), displacements_.size());
+}
+
+size_t PerfectHash::GetPosition(uint64_t hash, uint32_t displacement) const {
+    return ReduceToRange(static_cast<uint32_t>(Mix(hash + displacement * 0x9e3779b97f4a7c15ULL)), size_);
+}
+
+void PerfectHash::Build(const std::vector<std::string_view>& keys) {
+    size_ = keys.size();
+    displacements_.assign(std::max<size_t>(1, size_ / KEYS_PER_BUCKET), 0);
+    for (int attempt = 0; attempt < MAX_ATTEMPTS; ++attempt) {
+        seed_ = Mix(attempt + 1);
+        std::vector<uint64_t> hashes;
+        hashes.reserve(keys.size());
+        for (std::string_view key : keys) {
+            hashes.push_back(Hash(key));
+        }
+        if (TryBuild(hashes)) {
+            return;
+        }
+    }
+    throw std::runtime_error("Failed to build a perfect hash, keys may repeat");
+}
+
+//Корзины размещаются от больших к малым: пока позиций свободно много, большие корзины легко уложить
+bool PerfectHash::TryBuild(const std::vector<uint64_t>& hashes) {
+    std::vector<std::vector<uint64_t>> buckets(displacements_.size());
+    for (uint64_t hash : hashes) {
+        buckets[GetBucket(hash)].push_back(hash);
+    }
+    std::vector<uint32_t> order(buckets.size());
+    for (uint32_t bucket = 0; bucket < order.size(); ++bucket) {
+        order[bucket] = bucket;
+    }
+    std::stable_sort(order.begin(), order.end(), [&buckets](uint32_t lhs, uint32_t rhs) {
+        return buckets[lhs].size() > buckets[rhs].size();
+    });
+
+    std::vector<bool> is_taken(size_);
+    std::vector<size_t> positions;
+    for (uint32_t bucket : order) {
+        if (buckets[bucket].empty()) {
+            break;
+        }
+        //Одинаковые хеши не разделит никакое смещение: нужно другое зерно, а если ключи повторяются - ошибка
+        const auto& hashes_in_bucket = buckets[bucket];
+        for (auto it = hashes_in_bucket.begin(); it != hashes_in_bucket.end(); ++it) {
+            if (std::find(std::next(it), hashes_in_bucket.end(), *it) != hashes_in_bucket.end()) {
+                return false;
+            }
+        }
+        bool is_placed = false;
+        for (uint32_t displacement = 0; displacement < MAX_DISPLACEMENT && !is_placed; ++displacement) {
+            positions.clear();
+            is_placed = true;
+            for (uint64_t hash : buckets[bucket]) {
+                const size_t position = GetPosition(hash, displacement);
+                if (is_taken[position] || std::find(positions.begin(), positions.end(), position) != positions.end()) {
+                    is_placed = false;
+                    break;
+                }
+                positions.push_back(position);
+            }
+            if (is_placed) {
+                displacements_[bucket] = displacement;
+            }
+        }
+        if (!is_placed) {
+            return false;
+        }
+        for (size_t position : positions) {
+            is_taken[position] = true;
+        }
+    }
+    return true;
+}
+
+size_t PerfectHash::Find(std::string_view key) const {
+    const uint64_t hash = Hash(key);
+    return GetPosition(hash, displacements_[GetBucket(hash)]);
+}
+
+size_t PerfectHash::Size() const {
+    return size_;
+}
+
+void PerfectHash::Clear() {
+    size_ = 0;
+    displacements_.clear();
+    displacements_.shrink_to_fit();
+}
+
+memory::Usage PerfectHash::GetMemoryUsage() const {
+    return {"perfect_hash", memory::VectorBytes(displacements_), size_};
+}
+
+} //transport_catalogue
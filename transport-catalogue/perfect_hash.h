@@ -0,0 +1,37 @@
+#pragma once
+
+#include "memory_usage.h"
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace transport_catalogue {
+
+//Минимальная совершенная хеш-функция (CHD) для неизменного набора различных строк.
+//Ключи раскладываются по корзинам, для каждой корзины подбирается смещение, при котором
+//её ключи попадают в свободные позиции. n ключей получают позиции 0..n-1 без коллизий,
+//а хранится только смещение на каждые несколько ключей.
+//Для строки не из набора Find тоже возвращает какую-то позицию: ключ в ней нужно сравнить.
+class PerfectHash {
+public:
+    void Build(const std::vector<std::string_view>& keys); //Ключи не повторяются
+    size_t Find(std::string_view key) const; //Позиция меньше Size(); набор не должен быть пуст
+    size_t Size() const;
+    void Clear();
+    memory::Usage GetMemoryUsage() const;
+
+private:
+    static constexpr size_t KEYS_PER_BUCKET = 4;
+
+    uint64_t Hash(std::string_view key) const;
+    size_t GetBucket(uint64_t hash) const;
+    size_t GetPosition(uint64_t hash, uint32_t displacement) const;
+    bool TryBuild(const std::vector<uint64_t>& hashes);
+
+    uint64_t seed_ = 0;
+    size_t size_ = 0;
+    std::vector<uint32_t> displacements_; //Смещение каждой корзины
+};
+
+} //transport_catalogue
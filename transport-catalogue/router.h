@@ -6,6 +6,7 @@
 #include <cassert>
 #include <cstdint>
 #include <iterator>
+#include <memory_resource>
 #include <optional>
 #include <stdexcept>
 #include <unordered_map>
@@ -24,10 +25,13 @@ public:
 
     struct RouteInfo {
         Weight weight;
-        std::vector<EdgeId> edges;
+        std::pmr::vector<EdgeId> edges;
     };
 
-    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to,
+                                        std::pmr::memory_resource* resource = std::pmr::get_default_resource()) const;
+    memory::Usage GetMemoryUsage() const; //Матрица кратчайших путей между всеми вершинами
+    static size_t EstimateMemoryUsage(size_t vertex_count); //Размер матрицы до построения
 
 private:
     struct RouteInternalData {
@@ -95,14 +99,30 @@ Router<Weight>::Router(const Graph& graph)
 }
 
 template <typename Weight>
-std::optional<typename Router<Weight>::RouteInfo> Router<Weight>::BuildRoute(VertexId from,
-                                                                             VertexId to) const {
+size_t Router<Weight>::EstimateMemoryUsage(size_t vertex_count) {
+    return memory::AllocationSize(vertex_count * sizeof(std::vector<std::optional<RouteInternalData>>))
+        + vertex_count * memory::AllocationSize(vertex_count * sizeof(std::optional<RouteInternalData>));
+}
+
+template <typename Weight>
+memory::Usage Router<Weight>::GetMemoryUsage() const {
+    memory::Usage usage{"router.routes", memory::VectorBytes(routes_internal_data_), 0};
+    for (const auto& row : routes_internal_data_) {
+        usage.bytes += memory::VectorBytes(row);
+        usage.elements += row.size();
+    }
+    return usage;
+}
+
+template <typename Weight>
+std::optional<typename Router<Weight>::RouteInfo> Router<Weight>::BuildRoute(VertexId from, VertexId to,
+                                                                             std::pmr::memory_resource* resource) const {
     const auto& route_internal_data = routes_internal_data_.at(from).at(to);
     if (!route_internal_data) {
         return std::nullopt;
     }
     const Weight weight = route_internal_data->weight;
-    std::vector<EdgeId> edges;
+    std::pmr::vector<EdgeId> edges(resource);
     for (std::optional<EdgeId> edge_id = route_internal_data->prev_edge;
          edge_id;
          edge_id = routes_internal_data_[from][graph_.GetEdge(*edge_id).from]->prev_edge)
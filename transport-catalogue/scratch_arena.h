@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+
+namespace transport_catalogue {
+
+//Память для временных структур одного запроса. Выделения идут подряд из буфера,
+//а Reset после запроса возвращает весь буфер сразу, без обращений к malloc.
+//Запрос, которому не хватило буфера, добирает память из кучи; она освобождается при Reset.
+class ScratchArena {
+public:
+    static constexpr size_t DEFAULT_SIZE = 64 * 1024;
+
+    explicit ScratchArena(size_t size = DEFAULT_SIZE)
+        : buffer_(std::make_unique<std::byte[]>(size))
+        , resource_(buffer_.get(), size) {
+    }
+    ScratchArena(const ScratchArena&) = delete;
+    ScratchArena& operator=(const ScratchArena&) = delete;
+
+    std::pmr::memory_resource* GetResource() {
+        return &resource_;
+    }
+    void Reset() {
+        resource_.release();
+    }
+
+private:
+    std::unique_ptr<std::byte[]> buffer_;
+    std::pmr::monotonic_buffer_resource resource_;
+};
+
+//Арена потока: задачи пула берут её, а не заводят свою на каждый кусок запросов
+inline ScratchArena& GetThreadScratchArena() {
+    thread_local ScratchArena arena;
+    return arena;
+}
+
+} //transport_catalogue
@@ -0,0 +1,322 @@
+#include "serialization.h"
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string_view>
+#include <type_traits>
+#include <tuple>
+#include <vector>
+
+namespace transport_catalogue {
+
+using namespace std::literals;
+
+namespace {
+
+constexpr char SNAPSHOT_MAGIC[8] = {'T', 'C', 'A', 'T', 'S', 'N', 'A', 'P'};
+constexpr uint32_t SNAPSHOT_VERSION = 2;
+//В версии 1 некольцевой маршрут записан с обратным ходом, при чтении он отбрасывается
+constexpr uint32_t EXPANDED_ROUTES_VERSION = 1;
+constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint64_t payload_size;
+    uint64_t checksum;
+};
+
+uint64_t ComputeChecksum(std::string_view data) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (const unsigned char c : data) {
+        hash ^= c;
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+class Writer {
+public:
+    template <typename Value>
+    void Write(Value value) {
+        static_assert(std::is_trivially_copyable_v<Value>);
+        buffer_.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    void WriteString(std::string_view value) {
+        Write(static_cast<uint32_t>(value.size()));
+        buffer_.append(value);
+    }
+
+    void WriteColor(const svg::Color& color) {
+        Write(static_cast<uint8_t>(color.index()));
+        if (const auto* name = std::get_if<std::string>(&color)) {
+            WriteString(*name);
+        }
+        else if (const auto* rgb = std::get_if<svg::Rgb>(&color)) {
+            Write(*rgb);
+        }
+        else if (const auto* rgba = std::get_if<svg::Rgba>(&color)) {
+            Write(rgba->red);
+            Write(rgba->green);
+            Write(rgba->blue);
+            Write(rgba->opacity);
+        }
+    }
+
+    const std::string& GetBuffer() const {
+        return buffer_;
+    }
+
+private:
+    std::string buffer_;
+};
+
+class Reader {
+public:
+    explicit Reader(std::string_view data)
+        : data_(data) {
+    }
+
+    template <typename Value>
+    Value Read() {
+        static_assert(std::is_trivially_copyable_v<Value>);
+        Value value;
+        std::memcpy(&value, Take(sizeof(value)).data(), sizeof(value));
+        return value;
+    }
+
+    std::string_view ReadString() {
+        return Take(Read<uint32_t>());
+    }
+
+    svg::Color ReadColor() {
+        switch (Read<uint8_t>()) {
+            case 0:
+                return std::monostate{};
+            case 1:
+                return std::string(ReadString());
+            case 2:
+                return Read<svg::Rgb>();
+            case 3: {
+                svg::Rgba rgba;
+                rgba.red = Read<uint8_t>();
+                rgba.green = Read<uint8_t>();
+                rgba.blue = Read<uint8_t>();
+                rgba.opacity = Read<double>();
+                return rgba;
+            }
+        }
+        throw SnapshotError("Unknown color type in snapshot"s);
+    }
+
+    bool IsEnd() const {
+        return data_.empty();
+    }
+
+private:
+    std::string_view Take(size_t size) {
+        if (size > data_.size()) {
+            throw SnapshotError("Unexpected end of snapshot"s);
+        }
+        std::string_view result = data_.substr(0, size);
+        data_.remove_prefix(size);
+        return result;
+    }
+
+    std::string_view data_;
+};
+
+void WriteRenderSettings(Writer& writer, const RenderSettings& settings) {
+    writer.Write(settings.width);
+    writer.Write(settings.height);
+    writer.Write(settings.padding);
+    writer.Write(settings.stop_radius);
+    writer.Write(settings.line_width);
+    writer.Write(settings.bus_label_font_size);
+    writer.Write(settings.bus_label_offset[0]);
+    writer.Write(settings.bus_label_offset[1]);
+    writer.Write(settings.stop_label_font_size);
+    writer.Write(settings.stop_label_offset[0]);
+    writer.Write(settings.stop_label_offset[1]);
+    writer.WriteColor(settings.underlayer_color);
+    writer.Write(settings.underlayer_width);
+    writer.Write(static_cast<uint32_t>(settings.color_palette.size()));
+    for (const auto& color : settings.color_palette) {
+        writer.WriteColor(color);
+    }
+}
+
+RenderSettings ReadRenderSettings(Reader& reader) {
+    RenderSettings settings;
+    settings.width = reader.Read<double>();
+    settings.height = reader.Read<double>();
+    settings.padding = reader.Read<double>();
+    settings.stop_radius = reader.Read<double>();
+    settings.line_width = reader.Read<double>();
+    settings.bus_label_font_size = reader.Read<int>();
+    settings.bus_label_offset[0] = reader.Read<double>();
+    settings.bus_label_offset[1] = reader.Read<double>();
+    settings.stop_label_font_size = reader.Read<int>();
+    settings.stop_label_offset[0] = reader.Read<double>();
+    settings.stop_label_offset[1] = reader.Read<double>();
+    settings.underlayer_color = reader.ReadColor();
+    settings.underlayer_width = reader.Read<double>();
+    const uint32_t colors_count = reader.Read<uint32_t>();
+    for (uint32_t i = 0; i < colors_count; ++i) {
+        settings.color_palette.push_back(reader.ReadColor());
+    }
+    return settings;
+}
+
+} //namespace
+
+void SaveCatalogue(const std::string& path, const TransportCatalogue& catalogue, const std::optional<RenderSettings>& render_settings) {
+    Writer writer;
+    writer.Write(catalogue.GetSpeed());
+    writer.Write(catalogue.GetWaitTime());
+
+    const auto& stops = catalogue.GetStops();
+    writer.Write(static_cast<uint32_t>(stops.size()));
+    for (const Stop& stop : stops) {
+        writer.WriteString(stop.name);
+        writer.Write(stop.coordinates.lat);
+        writer.Write(stop.coordinates.lng);
+    }
+
+    std::vector<std::tuple<StopId, StopId, int>> distances;
+    catalogue.GetDistances().ForEach([&distances](StopId from, StopId to, int distance) {
+        distances.push_back({from, to, distance});
+    });
+    writer.Write(static_cast<uint32_t>(distances.size()));
+    for (const auto& [from, to, distance] : distances) {
+        writer.Write(from);
+        writer.Write(to);
+        writer.Write(distance);
+    }
+
+    const auto& buses = catalogue.GetBuses();
+    writer.Write(static_cast<uint32_t>(buses.size()));
+    for (const Bus& bus : buses) {
+        writer.WriteString(bus.name);
+        writer.Write(static_cast<uint8_t>(bus.is_roundtrip));
+        const StopSequence stops = catalogue.GetBusStops(bus);
+        writer.Write(static_cast<uint32_t>(stops.size()));
+        for (StopId stop : stops) {
+            writer.Write(stop);
+        }
+    }
+
+    writer.Write(static_cast<uint8_t>(render_settings.has_value()));
+    if (render_settings) {
+        WriteRenderSettings(writer, *render_settings);
+    }
+
+    const std::string& payload = writer.GetBuffer();
+    SnapshotHeader header{};
+    std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.byte_order = BYTE_ORDER_MARK;
+    header.payload_size = payload.size();
+    header.checksum = ComputeChecksum(payload);
+
+    std::ofstream output(path, std::ios::binary | std::ios::trunc);
+    output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    output.write(payload.data(), payload.size());
+    if (!output) {
+        throw SnapshotError("Failed to write snapshot "s + path);
+    }
+}
+
+std::optional<RenderSettings> LoadCatalogue(const std::string& path, TransportCatalogue& catalogue) {
+    if (!catalogue.GetStops().empty()) {
+        throw SnapshotError("Snapshot can be loaded only into an empty catalogue"s);
+    }
+    std::ifstream input(path, std::ios::binary);
+    if (!input) {
+        throw SnapshotError("Failed to open snapshot "s + path);
+    }
+    input.seekg(0, std::ios::end);
+    const std::streamoff file_size = input.tellg();
+    input.seekg(0, std::ios::beg);
+    if (file_size < static_cast<std::streamoff>(sizeof(SnapshotHeader))) {
+        throw SnapshotError("Snapshot is too short"s);
+    }
+    std::string data(static_cast<size_t>(file_size), '\0');
+    input.read(data.data(), file_size);
+    if (!input) {
+        throw SnapshotError("Failed to read snapshot "s + path);
+    }
+
+    SnapshotHeader header;
+    std::memcpy(&header, data.data(), sizeof(header));
+    if (std::memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0) {
+        throw SnapshotError("Not a catalogue snapshot"s);
+    }
+    if (header.byte_order != BYTE_ORDER_MARK) {
+        throw SnapshotError("Snapshot was written with another byte order"s);
+    }
+    if (header.version != SNAPSHOT_VERSION && header.version != EXPANDED_ROUTES_VERSION) {
+        throw SnapshotError("Unsupported snapshot version "s + std::to_string(header.version));
+    }
+    const std::string_view payload = std::string_view(data).substr(sizeof(header));
+    if (header.payload_size != payload.size() || header.checksum != ComputeChecksum(payload)) {
+        throw SnapshotError("Snapshot is corrupted"s);
+    }
+
+    Reader reader(payload);
+    const double speed = reader.Read<double>();
+    const double wait = reader.Read<double>();
+    catalogue.AddSpeedAndWait(speed, wait);
+
+    const uint32_t stops_count = reader.Read<uint32_t>();
+    catalogue.Reserve(stops_count);
+    for (uint32_t i = 0; i < stops_count; ++i) {
+        const std::string_view name = reader.ReadString();
+        const double lat = reader.Read<double>();
+        const double lng = reader.Read<double>();
+        catalogue.AddStop(name, {lat, lng});
+    }
+
+    const uint32_t distances_count = reader.Read<uint32_t>();
+    for (uint32_t i = 0; i < distances_count; ++i) {
+        const StopId from = reader.Read<StopId>();
+        const StopId to = reader.Read<StopId>();
+        if (from >= stops_count || to >= stops_count) {
+            throw SnapshotError("Wrong stop id in snapshot"s);
+        }
+        catalogue.AddDistance(from, to, reader.Read<int>());
+    }
+
+    const uint32_t buses_count = reader.Read<uint32_t>();
+    std::vector<StopId> bus_stops;
+    for (uint32_t i = 0; i < buses_count; ++i) {
+        const std::string_view name = reader.ReadString();
+        const bool is_roundtrip = reader.Read<uint8_t>() != 0;
+        bus_stops.resize(reader.Read<uint32_t>());
+        for (StopId& stop : bus_stops) {
+            stop = reader.Read<StopId>();
+            if (stop >= stops_count) {
+                throw SnapshotError("Wrong stop id in snapshot"s);
+            }
+        }
+        if (header.version == EXPANDED_ROUTES_VERSION && !is_roundtrip && !bus_stops.empty()) {
+            bus_stops.resize(bus_stops.size() / 2 + 1);
+        }
+        catalogue.AddBus(name, bus_stops, is_roundtrip);
+    }
+    catalogue.BuildIndexes();
+
+    std::optional<RenderSettings> render_settings;
+    if (reader.Read<uint8_t>() != 0) {
+        render_settings = ReadRenderSettings(reader);
+    }
+    if (!reader.IsEnd()) {
+        throw SnapshotError("Unexpected data at the end of snapshot"s);
+    }
+    return render_settings;
+}
+
+} //transport_catalogue
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "transport_catalogue.h"
+#include "map_renderer.h"
+
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+namespace transport_catalogue {
+
+//Ошибка чтения снимка: нет файла, чужой формат, другая версия или повреждённые данные
+class SnapshotError : public std::runtime_error {
+public:
+    using runtime_error::runtime_error;
+};
+
+//Двоичный снимок каталога: остановки с координатами, явно заданные расстояния,
+//маршруты с номерами остановок прямого хода и признаком кольцевого, настройки маршрутизации и отрисовки.
+//Заголовок содержит формат, версию, размер и контрольную сумму FNV-1a данных.
+//Числа записываются в порядке байт машины; снимок с другим порядком не читается.
+void SaveCatalogue(const std::string& path, const TransportCatalogue& catalogue, const std::optional<RenderSettings>& render_settings);
+
+//Заполняет пустой каталог из снимка одним последовательным чтением файла
+//и возвращает сохранённые настройки отрисовки
+std::optional<RenderSettings> LoadCatalogue(const std::string& path, TransportCatalogue& catalogue);
+
+} //transport_catalogue
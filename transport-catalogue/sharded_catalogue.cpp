@@ -0,0 +1,363 @@
+#include "sharded_catalogue.h"
+#include "json_reader.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <set>
+#include <sstream>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace transport_catalogue {
+
+using namespace std::literals;
+
+namespace {
+
+void SendAll(int socket, const char* data, size_t size) {
+    while (size > 0) {
+        //MSG_NOSIGNAL: упавший обработчик даёт ошибку, а не SIGPIPE главному процессу
+        const ssize_t sent = send(socket, data, size, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::system_error(errno, std::generic_category(), "send");
+        }
+        data += sent;
+        size -= sent;
+    }
+}
+
+//false, если сокет закрыт до первого байта
+bool ReceiveAll(int socket, char* data, size_t size) {
+    size_t received_total = 0;
+    while (received_total < size) {
+        const ssize_t received = recv(socket, data + received_total, size - received_total, 0);
+        if (received < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::system_error(errno, std::generic_category(), "recv");
+        }
+        if (received == 0) {
+            if (received_total == 0) {
+                return false;
+            }
+            throw std::runtime_error("Connection closed in the middle of a message");
+        }
+        received_total += received;
+    }
+    return true;
+}
+
+void WriteMessage(int socket, const std::string& message) {
+    const uint64_t size = message.size();
+    SendAll(socket, reinterpret_cast<const char*>(&size), sizeof(size));
+    SendAll(socket, message.data(), message.size());
+}
+
+std::optional<std::string> ReadMessage(int socket) {
+    uint64_t size = 0;
+    if (!ReceiveAll(socket, reinterpret_cast<char*>(&size), sizeof(size))) {
+        return std::nullopt;
+    }
+    std::string message(size, '\0');
+    if (size > 0 && !ReceiveAll(socket, message.data(), size)) {
+        throw std::runtime_error("Connection closed in the middle of a message");
+    }
+    return message;
+}
+
+//Узел печатается на месте: документ не владеет им и не копирует его.
+//Ответы печатаются с точностью потока по умолчанию, как в выводе программы.
+std::string PrintNode(const json::Node& node, std::streamsize precision = 6) {
+    std::ostringstream output;
+    output.precision(precision);
+    json::Print(json::Document{std::shared_ptr<const json::Node>(std::shared_ptr<const json::Node>{}, &node)}, output);
+    return output.str();
+}
+
+json::Node LoadNode(const std::string& message) {
+    return json::Load(std::string_view(message)).GetRoot();
+}
+
+//Первое сообщение обработчику: его base_requests и настройки исходного запроса.
+//Координаты печатаются без округления, чтобы шард считал то же, что и целый каталог.
+std::string MakeBaseMessage(const json::Node& catalogue_data, const json::Node& base_requests) {
+    constexpr std::streamsize exact = std::numeric_limits<double>::max_digits10;
+    std::string message = "{\"base_requests\": "s + PrintNode(base_requests, exact);
+    for (const std::string_view key : {"routing_settings"sv, "render_settings"sv}) {
+        if (catalogue_data.AsMap().contains(key)) {
+            message += ", \""s + std::string(key) + "\": "s + PrintNode(catalogue_data.AsMap().at(key), exact);
+        }
+    }
+    return message + "}"s;
+}
+
+//Обработчик загружает каталог из первого сообщения и отвечает на пакеты запросов, пока главный процесс не закроет сокет
+void RunWorker(int socket) {
+    const auto base_message = ReadMessage(socket);
+    if (!base_message) {
+        return;
+    }
+    TransportCatalogue catalogue;
+    std::optional<RenderSettings> render_settings;
+    {
+        const json::Document base_data = json::Load(std::string_view(*base_message));
+        LoadCatalogueFromJson(catalogue, base_data.GetRoot());
+        render_settings = LoadRenderSettingsFromJson(base_data.GetRoot());
+    }
+    while (auto message = ReadMessage(socket)) {
+        const json::Node catalogue_data{json::Dict{{json::Key("stat_requests"), LoadNode(*message)}}};
+        WriteMessage(socket, PrintNode(ParseAndMakeAnswers(catalogue, render_settings, catalogue_data).GetRoot()));
+    }
+}
+
+//Ответы шардов на Stop: остановка найдена, если её нашёл хоть один шард
+json::Node MergeStopAnswers(std::vector<json::Node> answers) {
+    std::set<std::string> buses;
+    bool is_found = false;
+    for (const json::Node& answer : answers) {
+        if (!answer.AsMap().contains("buses")) {
+            continue;
+        }
+        is_found = true;
+        for (const json::Node& bus : answer.AsMap().at("buses").AsArray()) {
+            buses.emplace(bus.AsString());
+        }
+    }
+    if (!is_found) {
+        return std::move(answers.front());
+    }
+    json::Dict result = answers.front().AsMap();
+    result.erase("error_message");
+    result[json::Key("buses")] = json::Array(buses.begin(), buses.end());
+    return result;
+}
+
+} //namespace
+
+//Остановки нумеруются в порядке base_requests, как при загрузке каталога
+CataloguePartition PartitionBaseRequests(const json::Array& base_requests, size_t shards_count) {
+    std::unordered_map<std::string_view, size_t> stop_ids;
+    std::vector<std::pair<double, size_t>> longitudes;
+    for (const json::Node& request : base_requests) {
+        const json::Dict& request_map = request.AsMap();
+        if (request_map.at("type").AsString() == "Stop" && stop_ids.emplace(request_map.at("name").AsString(), stop_ids.size()).second) {
+            longitudes.push_back({request_map.at("longitude").AsDouble(), longitudes.size()});
+        }
+    }
+    const size_t stops_count = longitudes.size();
+    CataloguePartition partition;
+    partition.shards.resize(shards_count);
+
+    //Квантили долготы: после сортировки шард i получает i-ю долю остановок
+    std::sort(longitudes.begin(), longitudes.end());
+    std::vector<size_t> home_shard(stops_count);
+    for (size_t rank = 0; rank < stops_count; ++rank) {
+        home_shard[longitudes[rank].second] = rank * shards_count / stops_count;
+    }
+
+    std::vector<std::vector<bool>> is_member(shards_count, std::vector<bool>(stops_count));
+    for (size_t id = 0; id < stops_count; ++id) {
+        is_member[home_shard[id]][id] = true;
+    }
+    //Неизвестную остановку маршрута отклонит загрузка каталога в обработчике
+    std::vector<size_t> request_shard(base_requests.size());
+    for (size_t i = 0; i < base_requests.size(); ++i) {
+        const json::Dict& request_map = base_requests[i].AsMap();
+        if (request_map.at("type").AsString() != "Bus") {
+            continue;
+        }
+        const json::Array& bus_stops = request_map.at("stops").AsArray();
+        const auto first = bus_stops.empty() ? stop_ids.end() : stop_ids.find(bus_stops.front().AsString());
+        const size_t shard = first == stop_ids.end() ? 0 : home_shard[first->second];
+        request_shard[i] = shard;
+        partition.bus_shards[std::string(request_map.at("name").AsString())] = shard;
+        for (const json::Node& stop : bus_stops) {
+            if (auto it = stop_ids.find(stop.AsString()); it != stop_ids.end()) {
+                is_member[shard][it->second] = true;
+            }
+        }
+    }
+    for (const auto& [name, id] : stop_ids) {
+        std::vector<size_t>& shards = partition.stop_shards[std::string(name)];
+        shards.push_back(home_shard[id]);
+        for (size_t shard = 0; shard < shards_count; ++shard) {
+            if (shard != home_shard[id] && is_member[shard][id]) {
+                shards.push_back(shard);
+            }
+        }
+    }
+
+    //Остановка шарда берёт только расстояния до остановок того же шарда
+    for (size_t i = 0; i < base_requests.size(); ++i) {
+        const json::Dict& request_map = base_requests[i].AsMap();
+        if (request_map.at("type").AsString() == "Bus") {
+            partition.shards[request_shard[i]].push_back(base_requests[i]);
+            continue;
+        }
+        const size_t id = stop_ids.at(request_map.at("name").AsString());
+        for (size_t shard = 0; shard < shards_count; ++shard) {
+            if (!is_member[shard][id]) {
+                continue;
+            }
+            json::Dict distances;
+            for (const auto& [name, distance] : request_map.at("road_distances").AsMap()) {
+                if (auto it = stop_ids.find(name.AsString()); it != stop_ids.end() && is_member[shard][it->second]) {
+                    distances[name] = distance;
+                }
+            }
+            json::Dict stop = request_map;
+            stop[json::Key("road_distances")] = std::move(distances);
+            partition.shards[shard].push_back(std::move(stop));
+        }
+    }
+    return partition;
+}
+
+//Деструктор не вызывается для недостроенного объекта, поэтому уже запущенные обработчики
+//при ошибке останавливаются здесь
+ShardedCatalogue::ShardedCatalogue(const json::Node& catalogue_data, size_t shards_count) {
+    CataloguePartition partition = PartitionBaseRequests(catalogue_data.AsMap().at("base_requests").AsArray(), shards_count);
+    stop_shards_ = std::move(partition.stop_shards);
+    bus_shards_ = std::move(partition.bus_shards);
+    try {
+        for (json::Array& shard_requests : partition.shards) {
+            StartWorker(MakeBaseMessage(catalogue_data, json::Node(std::move(shard_requests))));
+        }
+    }
+    catch (...) {
+        StopWorkers();
+        throw;
+    }
+}
+
+//Обработчик запускается до загрузки каталога и получает base_requests через сокет,
+//поэтому не наследует от главного процесса ничего, кроме разобранного запроса
+size_t ShardedCatalogue::StartWorker(const std::string& base_message) {
+    int sockets[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) != 0) {
+        throw std::system_error(errno, std::generic_category(), "socketpair");
+    }
+    const pid_t pid = fork();
+    if (pid < 0) {
+        close(sockets[0]);
+        close(sockets[1]);
+        throw std::system_error(errno, std::generic_category(), "fork");
+    }
+    if (pid == 0) {
+        //Сокеты других обработчиков закрываются, чтобы те видели конец потока только от главного процесса
+        close(sockets[0]);
+        for (const Worker& worker : workers_) {
+            close(worker.socket);
+        }
+        int status = 0;
+        try {
+            RunWorker(sockets[1]);
+        }
+        catch (...) {
+            status = 1;
+        }
+        //Деструкторы и буферы вывода принадлежат главному процессу
+        _exit(status);
+    }
+    close(sockets[1]);
+    workers_.push_back({pid, sockets[0]});
+    WriteMessage(sockets[0], base_message);
+    return workers_.size() - 1;
+}
+
+void ShardedCatalogue::StopWorkers() {
+    for (const Worker& worker : workers_) {
+        close(worker.socket);
+    }
+    for (const Worker& worker : workers_) {
+        waitpid(worker.pid, nullptr, 0);
+    }
+    workers_.clear();
+    network_worker_.reset();
+}
+
+ShardedCatalogue::~ShardedCatalogue() {
+    StopWorkers();
+}
+
+json::Document ShardedCatalogue::ParseAndMakeAnswers(const json::Node& catalogue_data) {
+    const auto& stat_requests = catalogue_data.AsMap().at("stat_requests").AsArray();
+    const bool needs_network = std::any_of(stat_requests.begin(), stat_requests.end(), [](const json::Node& request) {
+        const auto& type = request.AsMap().at("type").AsString();
+        return type != "Bus" && type != "Stop";
+    });
+    if (needs_network && !network_worker_) {
+        network_worker_ = StartWorker(MakeBaseMessage(catalogue_data, catalogue_data.AsMap().at("base_requests")));
+    }
+
+    //Пакет запросов каждому обработчику и обработчики, отвечающие на каждый запрос
+    std::vector<json::Array> batches(workers_.size());
+    std::vector<std::vector<size_t>> request_workers(stat_requests.size());
+    for (size_t i = 0; i < stat_requests.size(); ++i) {
+        const auto& request = stat_requests[i].AsMap();
+        const auto& type = request.at("type").AsString();
+        //Неизвестные маршрут и остановку отклоняет любой шард
+        if (type == "Bus") {
+            auto it = bus_shards_.find(std::string(request.at("name").AsString()));
+            request_workers[i] = {it != bus_shards_.end() ? it->second : 0};
+        }
+        else if (type == "Stop") {
+            auto it = stop_shards_.find(std::string(request.at("name").AsString()));
+            request_workers[i] = it != stop_shards_.end() ? it->second : std::vector<size_t>{0};
+        }
+        else {
+            request_workers[i] = {*network_worker_};
+        }
+        for (size_t worker : request_workers[i]) {
+            batches[worker].push_back(stat_requests[i]);
+        }
+    }
+
+    //Сначала все пакеты отправляются, затем собираются ответы: шарды работают одновременно
+    std::vector<bool> is_sent(workers_.size());
+    for (size_t worker = 0; worker < workers_.size(); ++worker) {
+        if (!batches[worker].empty()) {
+            WriteMessage(workers_[worker].socket, PrintNode(std::move(batches[worker])));
+            is_sent[worker] = true;
+        }
+    }
+    std::vector<json::Array> worker_answers(workers_.size());
+    for (size_t worker = 0; worker < workers_.size(); ++worker) {
+        if (!is_sent[worker]) {
+            continue;
+        }
+        auto message = ReadMessage(workers_[worker].socket);
+        if (!message) {
+            throw std::runtime_error("Shard worker "s + std::to_string(worker) + " exited"s);
+        }
+        worker_answers[worker] = std::move(std::get<json::Array>(LoadNode(*message).GetValue()));
+    }
+
+    //Ответы каждого обработчика идут в порядке его пакета
+    std::vector<size_t> positions(workers_.size());
+    json::Array answers;
+    answers.reserve(stat_requests.size());
+    for (size_t i = 0; i < stat_requests.size(); ++i) {
+        std::vector<json::Node> request_answers;
+        for (size_t worker : request_workers[i]) {
+            request_answers.push_back(std::move(worker_answers[worker][positions[worker]++]));
+        }
+        answers.push_back(request_answers.size() == 1 ? std::move(request_answers.front()) : MergeStopAnswers(std::move(request_answers)));
+    }
+    return json::Document{std::move(answers)};
+}
+
+} //transport_catalogue
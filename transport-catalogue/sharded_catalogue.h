@@ -0,0 +1,60 @@
+#pragma once
+
+#include "json.h"
+
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <sys/types.h>
+
+namespace transport_catalogue {
+
+//base_requests, разрезанные по долготе на полосы с равным числом остановок.
+//Маршрут принадлежит шарду своей первой остановки, и все его остановки копируются в этот шард,
+//поэтому статистика маршрута считается внутри одного шарда.
+struct CataloguePartition {
+    std::vector<json::Array> shards; //base_requests каждого шарда: остановки с расстояниями внутри шарда и маршруты
+    std::unordered_map<std::string, std::vector<size_t>> stop_shards; //Шарды, где есть остановка, первым - домашний
+    std::unordered_map<std::string, size_t> bus_shards;
+};
+
+CataloguePartition PartitionBaseRequests(const json::Array& base_requests, size_t shards_count);
+
+//Шарды обслуживают процессы-обработчики на той же машине, с которыми главный процесс
+//общается через Unix-сокеты сообщениями "длина + JSON".
+//Главный процесс каталог не строит: после запуска обработчик получает первым сообщением
+//свою долю base_requests с настройками и сам загружает каталог, у главного остаются
+//только таблицы шардов остановок и маршрутов.
+//Bus уходит шарду маршрута, Stop - всем шардам с остановкой, списки маршрутов объединяются.
+//Route, Map, NearestStops и остальные запросы не шардируются и не масштабируются: им нужна вся сеть,
+//их обслуживает отдельный обработчик, который загружает все base_requests и строит маршрутизатор целиком.
+//Он запускается только для пакета, в котором есть такой запрос, поэтому запросы Bus и Stop
+//обходятся без процесса со всем каталогом.
+class ShardedCatalogue {
+public:
+    //catalogue_data - исходный запрос с base_requests, routing_settings и render_settings
+    ShardedCatalogue(const json::Node& catalogue_data, size_t shards_count);
+    ShardedCatalogue(const ShardedCatalogue&) = delete;
+    ShardedCatalogue& operator=(const ShardedCatalogue&) = delete;
+    ~ShardedCatalogue(); //Закрывает сокеты и дожидается завершения обработчиков
+
+    json::Document ParseAndMakeAnswers(const json::Node& catalogue_data);
+
+private:
+    struct Worker {
+        pid_t pid = -1;
+        int socket = -1;
+    };
+
+    size_t StartWorker(const std::string& base_message); //Номер обработчика в workers_
+    void StopWorkers();
+
+    std::vector<Worker> workers_; //Шарды, затем обработчик всей сети, если он запущен
+    std::optional<size_t> network_worker_;
+    std::unordered_map<std::string, std::vector<size_t>> stop_shards_;
+    std::unordered_map<std::string, size_t> bus_shards_;
+};
+
+} //transport_catalogue
@@ -0,0 +1,194 @@
+#define _USE_MATH_DEFINES
+
+#include "spatial_index.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <iterator>
+
+namespace transport_catalogue {
+
+namespace {
+
+const double EARTH_RADIUS = 6371000;
+
+double SquaredDistance(const double (&lhs)[3], const double (&rhs)[3]) {
+    const double dx = lhs[0] - rhs[0];
+    const double dy = lhs[1] - rhs[1];
+    const double dz = lhs[2] - rhs[2];
+    return dx * dx + dy * dy + dz * dz;
+}
+
+bool CompareByDistance(const std::pair<double, StopId>& lhs, const std::pair<double, StopId>& rhs) {
+    return lhs < rhs;
+}
+
+//best - max-куча из найденных точек, radius - квадрат хорды до худшей из них или до границы поиска
+void AddCandidate(double distance, StopId id, size_t count, std::vector<std::pair<double, StopId>>& best, double& radius) {
+    if (distance > radius) {
+        return;
+    }
+    best.push_back({distance, id});
+    std::push_heap(best.begin(), best.end(), CompareByDistance);
+    if (best.size() > count) {
+        std::pop_heap(best.begin(), best.end(), CompareByDistance);
+        best.pop_back();
+    }
+    if (best.size() == count) {
+        radius = best.front().first;
+    }
+}
+
+} //namespace
+
+void SpatialIndex::Build(const std::vector<UnitVector>& points) {
+    std::vector<Node> nodes;
+    nodes.reserve(points.size());
+    for (size_t i = 0; i < points.size(); ++i) {
+        nodes.push_back({{points[i].x, points[i].y, points[i].z}, static_cast<StopId>(i)});
+    }
+    BuildTree(std::move(nodes));
+}
+
+void SpatialIndex::BuildTree(std::vector<Node> nodes) {
+    BuildRange(nodes, 0, nodes.size(), 0);
+    std::vector<size_t> positions(positions_.size(), NO_POSITION);
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        if (nodes[i].id >= positions.size()) {
+            positions.resize(nodes[i].id + 1, NO_POSITION);
+        }
+        positions[nodes[i].id] = i;
+    }
+    nodes_ = {};
+    nodes_.reserve(nodes.size());
+    for (const Node& node : nodes) {
+        nodes_.push_back(node);
+    }
+    added_ = {};
+    erased_count_ = 0;
+    positions_ = {};
+    positions_.reserve(positions.size());
+    for (size_t position : positions) {
+        positions_.push_back(position);
+    }
+}
+
+//Перебор добавленных точек растёт линейно, поэтому дерево перестраивается, когда их больше корня
+//из размера дерева: на одно изменение приходится O(sqrt(n) log n) работы
+void SpatialIndex::RebuildIfNeeded() {
+    const size_t max_added = std::max<size_t>(32, static_cast<size_t>(std::sqrt(nodes_.size())));
+    if (added_.size() <= max_added && 4 * erased_count_ <= nodes_.size()) {
+        return;
+    }
+    std::vector<Node> nodes;
+    nodes.reserve(Size());
+    std::copy_if(nodes_.begin(), nodes_.end(), std::back_inserter(nodes), [](const Node& node) { return !node.is_erased; });
+    nodes.insert(nodes.end(), added_.begin(), added_.end());
+    BuildTree(std::move(nodes));
+}
+
+void SpatialIndex::Insert(StopId id, const UnitVector& point) {
+    while (id >= positions_.size()) {
+        positions_.push_back(NO_POSITION);
+    }
+    assert(positions_[id] == NO_POSITION);
+    positions_.Mutable(id) = nodes_.size() + added_.size();
+    added_.push_back({{point.x, point.y, point.z}, id});
+    RebuildIfNeeded();
+}
+
+void SpatialIndex::Erase(StopId id) {
+    const size_t position = positions_.at(id);
+    assert(position != NO_POSITION);
+    positions_.Mutable(id) = NO_POSITION;
+    if (position < nodes_.size()) {
+        nodes_.Mutable(position).is_erased = true;
+        ++erased_count_;
+    }
+    else {
+        //Последняя добавленная точка занимает место удалённой
+        const Node last = added_.back();
+        added_.Mutable(position - nodes_.size()) = last;
+        if (last.id != id) {
+            positions_.Mutable(last.id) = position;
+        }
+        added_.pop_back();
+    }
+    RebuildIfNeeded();
+}
+
+size_t SpatialIndex::Size() const {
+    return nodes_.size() - erased_count_ + added_.size();
+}
+
+memory::Usage SpatialIndex::GetMemoryUsage() const {
+    return {"", nodes_.GetMemoryBytes() + added_.GetMemoryBytes() + positions_.GetMemoryBytes(), Size()};
+}
+
+void SpatialIndex::BuildRange(std::vector<Node>& nodes, size_t begin, size_t end, int axis) {
+    if (end - begin < 2) {
+        return;
+    }
+    const size_t middle = begin + (end - begin) / 2;
+    std::nth_element(nodes.begin() + begin, nodes.begin() + middle, nodes.begin() + end,
+                     [axis](const Node& lhs, const Node& rhs) { return lhs.coordinates[axis] < rhs.coordinates[axis]; });
+    BuildRange(nodes, begin, middle, (axis + 1) % 3);
+    BuildRange(nodes, middle + 1, end, (axis + 1) % 3);
+}
+
+void SpatialIndex::Search(size_t begin, size_t end, int axis, const double (&point)[3], size_t count,
+                          std::vector<std::pair<double, StopId>>& best, double& radius) const {
+    if (begin >= end) {
+        return;
+    }
+    const size_t middle = begin + (end - begin) / 2;
+    const Node& node = nodes_[middle];
+    //Удалённый узел по-прежнему делит пространство, но в ответ не попадает
+    if (!node.is_erased) {
+        AddCandidate(SquaredDistance(point, node.coordinates), node.id, count, best, radius);
+    }
+    const double delta = point[axis] - node.coordinates[axis];
+    const int next_axis = (axis + 1) % 3;
+    //Сначала половина, в которой лежит точка, потом другая, если она ближе текущего радиуса
+    if (delta < 0) {
+        Search(begin, middle, next_axis, point, count, best, radius);
+        if (delta * delta <= radius) {
+            Search(middle + 1, end, next_axis, point, count, best, radius);
+        }
+    }
+    else {
+        Search(middle + 1, end, next_axis, point, count, best, radius);
+        if (delta * delta <= radius) {
+            Search(begin, middle, next_axis, point, count, best, radius);
+        }
+    }
+}
+
+std::vector<std::pair<StopId, double>> SpatialIndex::FindNearest(const UnitVector& point, size_t count, double max_distance) const {
+    std::vector<std::pair<StopId, double>> result;
+    //Отрицательный радиус дал бы положительную хорду, а перебор без индекса ничего не находит
+    if (count == 0 || Size() == 0 || !(max_distance >= 0)) {
+        return result;
+    }
+    //Квадрат хорды для центрального угла a: (2 sin(a / 2))^2
+    const double angle = max_distance / EARTH_RADIUS;
+    double radius = angle >= M_PI ? 4. : std::pow(2 * std::sin(angle / 2), 2);
+    const double target[3] = {point.x, point.y, point.z};
+    //Больше точек, чем есть в индексе, не найдётся: count из запроса не должен раздувать резерв
+    count = std::min(count, Size());
+    std::vector<std::pair<double, StopId>> best;
+    best.reserve(count + 1);
+    for (const Node& node : added_) {
+        AddCandidate(SquaredDistance(target, node.coordinates), node.id, count, best, radius);
+    }
+    Search(0, nodes_.size(), 0, target, count, best, radius);
+    std::sort_heap(best.begin(), best.end(), CompareByDistance);
+    result.reserve(best.size());
+    for (const auto& [chord, id] : best) {
+        result.push_back({id, 2 * std::asin(std::min(1., std::sqrt(chord) / 2)) * EARTH_RADIUS});
+    }
+    return result;
+}
+
+} //transport_catalogue
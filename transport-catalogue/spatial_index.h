@@ -0,0 +1,56 @@
+#pragma once
+
+#include "copy_on_write.h"
+#include "geo.h"
+#include "domain.h"
+#include "memory_usage.h"
+
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace transport_catalogue {
+
+//k-d дерево по единичным векторам остановок. Хорда между точками сферы растёт вместе
+//с расстоянием по поверхности, поэтому ближайшие по хорде точки - ближайшие и на Земле.
+//Дерево хранится в массиве: корень поддиапазона лежит в его середине.
+//Изменения не перестраивают дерево сразу: удалённые точки помечаются, новые просматриваются
+//перебором, пока их не накопится столько, что дешевле построить дерево заново.
+//Массивы индекса лежат в ChunkedVector: копии индекса делят их, а изменение точки копирует
+//только куски с ней, пока дерево не перестраивается.
+class SpatialIndex {
+public:
+    void Build(const std::vector<UnitVector>& points); //Номер точки - её позиция в points
+    void Insert(StopId id, const UnitVector& point);
+    void Erase(StopId id);
+    size_t Size() const;
+    memory::Usage GetMemoryUsage() const;
+
+    //Не больше count ближайших к point точек не дальше max_distance метров,
+    //по возрастанию расстояния: пары (номер точки, расстояние в метрах)
+    std::vector<std::pair<StopId, double>> FindNearest(const UnitVector& point, size_t count,
+                                                       double max_distance = std::numeric_limits<double>::infinity()) const;
+
+private:
+    static constexpr size_t NO_POSITION = SIZE_MAX;
+
+    struct Node {
+        double coordinates[3];
+        StopId id;
+        bool is_erased = false;
+    };
+
+    void BuildTree(std::vector<Node> nodes);
+    static void BuildRange(std::vector<Node>& nodes, size_t begin, size_t end, int axis);
+    void RebuildIfNeeded();
+    void Search(size_t begin, size_t end, int axis, const double (&point)[3], size_t count,
+                std::vector<std::pair<double, StopId>>& best, double& radius) const;
+
+    ChunkedVector<Node> nodes_; //Дерево
+    ChunkedVector<Node> added_; //Точки, добавленные после построения дерева
+    ChunkedVector<size_t> positions_; //Позиция точки в nodes_, а для добавленных - nodes_.size() + позиция в added_
+    size_t erased_count_ = 0; //Помеченные удалёнными узлы дерева
+};
+
+} //transport_catalogue
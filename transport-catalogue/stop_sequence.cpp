@@ -0,0 +1,200 @@
+#include "stop_sequence.h"
+
+
+namespace transport_catalogue {
+
+namespace {
+
+uint64_t ReadVarint(const uint8_t* position) {
+    uint64_t value = 0;
+    for (int shift = 0;; shift += 7) {
+        const uint8_t byte = *position++;
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            return value;
+        }
+    }
+}
+
+void WriteVarint(uint64_t value, std::vector<uint8_t>& bytes) {
+    while (value >= 0x80) {
+        bytes.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    bytes.push_back(static_cast<uint8_t>(value));
+}
+
+//Разность номеров со знаком: zigzag делает малые по модулю разности короткими
+StopId ReadDelta(const uint8_t* position) {
+    const uint64_t value = ReadVarint(position);
+    return static_cast<StopId>((value >> 1) ^ (~(value & 1) + 1));
+}
+
+void WriteDelta(StopId from, StopId to, std::vector<uint8_t>& bytes) {
+    const int64_t delta = static_cast<int64_t>(to) - static_cast<int64_t>(from);
+    WriteVarint((static_cast<uint64_t>(delta) << 1) ^ static_cast<uint64_t>(delta >> 63), bytes);
+}
+
+} //namespace
+
+StopSequence::Iterator& StopSequence::Iterator::operator++() {
+    if (ids_ != nullptr) {
+        ++ids_;
+        return *this;
+    }
+    while (*position_ & 0x80) {
+        ++position_;
+    }
+    ++position_;
+    if (position_ != end_) {
+        value_ += ReadDelta(position_);
+    }
+    return *this;
+}
+
+StopSequence::Iterator& StopSequence::Iterator::operator--() {
+    if (ids_ != nullptr) {
+        --ids_;
+        return *this;
+    }
+    if (position_ == end_) {
+        value_ = last_;
+    }
+    else {
+        value_ -= ReadDelta(position_);
+    }
+    //Предыдущий varint кончается байтом перед текущим, а начинается после конца ещё более раннего
+    --position_;
+    while (position_ != begin_ && (position_[-1] & 0x80)) {
+        --position_;
+    }
+    return *this;
+}
+
+StopSequence::StopSequence(const StopId* ids, size_t size)
+    : ids_(ids), size_(size) {
+}
+
+StopSequence::StopSequence(const uint8_t* bytes, size_t bytes_size, size_t size, StopId last)
+    : bytes_(bytes), bytes_size_(bytes_size), size_(size), last_(last) {
+}
+
+StopSequence::Iterator StopSequence::begin() const {
+    Iterator result;
+    if (bytes_ == nullptr) {
+        result.ids_ = ids_;
+        return result;
+    }
+    result.begin_ = bytes_;
+    result.end_ = bytes_ + bytes_size_;
+    result.position_ = bytes_;
+    result.last_ = last_;
+    if (size_ > 0) {
+        result.value_ = ReadDelta(bytes_);
+    }
+    return result;
+}
+
+StopSequence::Iterator StopSequence::end() const {
+    Iterator result;
+    if (bytes_ == nullptr) {
+        result.ids_ = ids_ + size_;
+        return result;
+    }
+    result.begin_ = bytes_;
+    result.end_ = bytes_ + bytes_size_;
+    result.position_ = result.end_;
+    result.last_ = last_;
+    return result;
+}
+
+SequenceId StopSequencePool::Add(const std::vector<StopId>& stops) {
+    if (!free_ids_.empty()) {
+        const SequenceId id = free_ids_.back();
+        free_ids_.pop_back();
+        runs_.Mutable(id) = MakeRun(stops);
+        return id;
+    }
+    runs_.push_back(MakeRun(stops));
+    return static_cast<SequenceId>(runs_.size() - 1);
+}
+
+void StopSequencePool::Set(SequenceId id, const std::vector<StopId>& stops) {
+    if (id >= runs_.size()) {
+        throw std::out_of_range("Unknown stop sequence");
+    }
+    runs_.Mutable(id) = MakeRun(stops);
+}
+
+void StopSequencePool::Erase(SequenceId id) {
+    if (id >= runs_.size()) {
+        throw std::out_of_range("Unknown stop sequence");
+    }
+    runs_.Mutable(id) = nullptr;
+    free_ids_.push_back(id);
+}
+
+StopSequence StopSequencePool::Get(SequenceId id) const {
+    const Run* run = runs_[id].get();
+    if (run == nullptr) {
+        return {};
+    }
+    if (encoding_ == Encoding::Plain) {
+        return {run->ids.data(), run->size};
+    }
+    return {run->bytes.data(), run->bytes.size(), run->size, run->last};
+}
+
+std::shared_ptr<const StopSequencePool::Run> StopSequencePool::MakeRun(const std::vector<StopId>& stops) const {
+    auto run = std::make_shared<Run>();
+    run->size = static_cast<uint32_t>(stops.size());
+    run->last = stops.empty() ? 0 : stops.back();
+    if (encoding_ == Encoding::Plain) {
+        run->ids = stops;
+        return run;
+    }
+    run->bytes.reserve(stops.size() * 2);
+    StopId previous = 0;
+    for (StopId stop : stops) {
+        WriteDelta(previous, stop, run->bytes);
+        previous = stop;
+    }
+    run->bytes.shrink_to_fit();
+    return run;
+}
+
+void StopSequencePool::SetEncoding(Encoding encoding) {
+    if (encoding == encoding_) {
+        return;
+    }
+    std::vector<std::vector<StopId>> sequences;
+    sequences.reserve(runs_.size());
+    for (SequenceId id = 0; id < runs_.size(); ++id) {
+        const StopSequence sequence = Get(id);
+        sequences.emplace_back(sequence.begin(), sequence.end());
+    }
+    encoding_ = encoding;
+    for (SequenceId id = 0; id < runs_.size(); ++id) {
+        if (runs_[id] != nullptr) {
+            runs_.Mutable(id) = MakeRun(sequences[id]);
+        }
+    }
+}
+
+StopSequencePool::Encoding StopSequencePool::GetEncoding() const {
+    return encoding_;
+}
+
+//Общие последовательности учитываются в каждой копии пула, которая их держит
+memory::Usage StopSequencePool::GetMemoryUsage() const {
+    memory::Usage usage{"stop_sequences", runs_.GetMemoryBytes() + free_ids_.GetMemoryBytes(), 0};
+    for (const auto& run : runs_) {
+        if (run != nullptr) {
+            usage.bytes += copy_on_write_detail::SharedBytes<Run>() + memory::VectorBytes(run->ids) + memory::VectorBytes(run->bytes);
+            usage.elements += run->size;
+        }
+    }
+    return usage;
+}
+
+} //transport_catalogue
@@ -0,0 +1,229 @@
+#pragma once
+
+#include "copy_on_write.h"
+#include "domain.h"
+#include "memory_usage.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+namespace transport_catalogue {
+
+//Остановки одной последовательности из StopSequencePool: номера остановок в порядке хранения.
+//В сжатом виде номер - разность с предыдущим в varint, поэтому итератор раскодирует на ходу
+//и двигается в обе стороны: последний байт каждого varint - единственный со сброшенным старшим битом.
+class StopSequence {
+public:
+    class Iterator {
+    public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = StopId;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const StopId*;
+        using reference = StopId;
+
+        Iterator() = default;
+
+        StopId operator*() const {
+            return ids_ != nullptr ? *ids_ : value_;
+        }
+        Iterator& operator++();
+        Iterator operator++(int) {
+            Iterator result = *this;
+            ++*this;
+            return result;
+        }
+        Iterator& operator--();
+        Iterator operator--(int) {
+            Iterator result = *this;
+            --*this;
+            return result;
+        }
+        bool operator==(const Iterator& other) const {
+            return ids_ == other.ids_ && position_ == other.position_;
+        }
+
+    private:
+        friend class StopSequence;
+
+        const StopId* ids_ = nullptr; //Несжатая последовательность
+        const uint8_t* position_ = nullptr; //Начало varint текущего номера в сжатой
+        const uint8_t* begin_ = nullptr;
+        const uint8_t* end_ = nullptr;
+        StopId value_ = 0;
+        StopId last_ = 0;
+    };
+
+    StopSequence() = default;
+    StopSequence(const StopId* ids, size_t size);
+    StopSequence(const uint8_t* bytes, size_t bytes_size, size_t size, StopId last);
+
+    size_t size() const {
+        return size_;
+    }
+    bool empty() const {
+        return size_ == 0;
+    }
+    Iterator begin() const;
+    Iterator end() const;
+    StopId front() const {
+        return *begin();
+    }
+    StopId back() const {
+        return *std::prev(end());
+    }
+
+private:
+    const StopId* ids_ = nullptr;
+    const uint8_t* bytes_ = nullptr;
+    size_t bytes_size_ = 0;
+    size_t size_ = 0;
+    StopId last_ = 0;
+};
+
+//Последовательности остановок всех маршрутов каталога: 32-битные номера или, в сжатом режиме
+//для редко читаемых данных, байты varint. Последовательность адресуется постоянным номером
+//и после записи не меняется, поэтому копии пула делят её, а изменение маршрута
+//заменяет только его последовательность и кусок указателей на последовательности.
+class StopSequencePool {
+public:
+    enum class Encoding {
+        Plain, //4 байта на остановку
+        Delta, //Разности соседних номеров в varint, обычно 1-2 байта на остановку
+    };
+
+    SequenceId Add(const std::vector<StopId>& stops);
+    void Set(SequenceId id, const std::vector<StopId>& stops);
+    void Erase(SequenceId id);
+    StopSequence Get(SequenceId id) const; //Действительна, пока пул или его копия держит последовательность
+    void SetEncoding(Encoding encoding); //Перекодирует все последовательности
+    Encoding GetEncoding() const;
+    memory::Usage GetMemoryUsage() const;
+
+private:
+    struct Run {
+        std::vector<StopId> ids; //Только в обычном режиме
+        std::vector<uint8_t> bytes; //Только в сжатом
+        uint32_t size = 0;
+        StopId last = 0; //Для обхода сжатой последовательности с конца
+    };
+
+    std::shared_ptr<const Run> MakeRun(const std::vector<StopId>& stops) const;
+
+    Encoding encoding_ = Encoding::Plain;
+    ChunkedVector<std::shared_ptr<const Run>> runs_; //По номеру последовательности, у удалённой - пустой
+    ChunkedVector<SequenceId> free_ids_;
+};
+
+//Остановки маршрута в порядке проезда без копирования: у некольцевого маршрута
+//за прямым ходом A->B->C следует обратный C->B->A без повтора конечной
+class RouteStops {
+public:
+    class Iterator {
+    public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = Stop;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const Stop*;
+        using reference = const Stop&;
+
+        Iterator() = default;
+        Iterator(const ChunkedVector<Stop>* stops, StopSequence::Iterator position, size_t forward_size, size_t size, size_t index)
+            : stops_(stops), position_(position), forward_size_(forward_size), size_(size), index_(index) {
+        }
+
+        reference operator*() const {
+            return (*stops_)[*position_];
+        }
+        pointer operator->() const {
+            return &**this;
+        }
+        //Позиция в прямом ходе растёт до конечной, затем убывает; за последней остановкой не двигается
+        Iterator& operator++() {
+            if (index_ + 1 < forward_size_) {
+                ++position_;
+            }
+            else if (index_ + 1 < size_) {
+                --position_;
+            }
+            ++index_;
+            return *this;
+        }
+        Iterator operator++(int) {
+            Iterator result = *this;
+            ++*this;
+            return result;
+        }
+        Iterator& operator--() {
+            if (index_ < forward_size_) {
+                --position_;
+            }
+            else if (index_ < size_) {
+                ++position_;
+            }
+            --index_;
+            return *this;
+        }
+        Iterator operator--(int) {
+            Iterator result = *this;
+            --*this;
+            return result;
+        }
+        difference_type operator-(const Iterator& other) const {
+            return static_cast<difference_type>(index_) - static_cast<difference_type>(other.index_);
+        }
+        bool operator==(const Iterator& other) const {
+            return index_ == other.index_;
+        }
+
+    private:
+        const ChunkedVector<Stop>* stops_ = nullptr;
+        StopSequence::Iterator position_;
+        size_t forward_size_ = 0;
+        size_t size_ = 0;
+        size_t index_ = 0;
+    };
+
+    RouteStops(const ChunkedVector<Stop>& stops, StopSequence sequence, bool is_roundtrip)
+        : stops_(&stops), sequence_(sequence), is_roundtrip_(is_roundtrip) {
+    }
+
+    size_t size() const {
+        return is_roundtrip_ || sequence_.empty() ? sequence_.size() : 2 * sequence_.size() - 1;
+    }
+    bool empty() const {
+        return sequence_.empty();
+    }
+    Iterator begin() const {
+        return {stops_, sequence_.begin(), sequence_.size(), size(), 0};
+    }
+    //Конец стоит на последней остановке маршрута, чтобы шаг назад не раскодировал последовательность заново
+    Iterator end() const {
+        StopSequence::Iterator last = is_roundtrip_ || sequence_.empty() ? sequence_.end() : sequence_.begin();
+        if (is_roundtrip_ && !sequence_.empty()) {
+            --last;
+        }
+        return {stops_, last, sequence_.size(), size(), size()};
+    }
+    //За линейное время: сжатую последовательность нельзя индексировать
+    const Stop& operator[](size_t index) const {
+        return *std::next(begin(), index);
+    }
+    const Stop& at(size_t index) const {
+        if (index >= size()) {
+            throw std::out_of_range("Route stop index is out of range");
+        }
+        return (*this)[index];
+    }
+
+private:
+    const ChunkedVector<Stop>* stops_;
+    StopSequence sequence_;
+    bool is_roundtrip_;
+};
+
+} //transport_catalogue
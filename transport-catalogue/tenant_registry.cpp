@@ -0,0 +1,232 @@
+#include "tenant_registry.h"
+#include "json_builder.h"
+#include "json_reader.h"
+#include "scratch_arena.h"
+
+#include <algorithm>
+#include <bit>
+#include <future>
+#include <string_view>
+#include <vector>
+
+namespace transport_catalogue {
+
+using namespace std::literals;
+
+namespace {
+
+bool NeedsRoutesManager(const json::Node& request) {
+    const auto& type = request.AsMap().at("type").AsString();
+    return type == "Route" || type == "Memory";
+}
+
+void MakeErrorAnswer(const json::Node& request, std::string_view message, json::Builder& builder) {
+    builder.StartDict().Key("request_id").Value(request.AsMap().at("id").AsInt()).Key("error_message").Value(std::string(message)).EndDict();
+}
+
+//Память каталога без общей арены имён
+size_t GetCatalogueMemoryUsage(const TransportCatalogue& catalogue) {
+    size_t bytes = 0;
+    for (const memory::Usage& usage : catalogue.GetMemoryUsage()) {
+        if (!usage.name.starts_with("catalogue.names."sv)) {
+            bytes += usage.bytes;
+        }
+    }
+    return bytes;
+}
+
+} //namespace
+
+void LatencyMetrics::Record(std::chrono::nanoseconds latency) {
+    const uint64_t ns = static_cast<uint64_t>(std::max<int64_t>(latency.count(), 0));
+    count_.fetch_add(1, std::memory_order_relaxed);
+    total_ns_.fetch_add(ns, std::memory_order_relaxed);
+    uint64_t max_ns = max_ns_.load(std::memory_order_relaxed);
+    while (ns > max_ns && !max_ns_.compare_exchange_weak(max_ns, ns, std::memory_order_relaxed)) {
+    }
+    //Корзина i - задержки меньше 2^i микросекунд
+    const size_t bucket = std::min<size_t>(std::bit_width(ns / 1000), BUCKETS_COUNT - 1);
+    buckets_[bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+double LatencyMetrics::GetPercentile(uint64_t count, double share) const {
+    const double target = share * count;
+    uint64_t seen = 0;
+    for (size_t bucket = 0; bucket < BUCKETS_COUNT; ++bucket) {
+        seen += buckets_[bucket].load(std::memory_order_relaxed);
+        if (seen >= target) {
+            return static_cast<double>(uint64_t{1} << bucket);
+        }
+    }
+    return static_cast<double>(uint64_t{1} << (BUCKETS_COUNT - 1));
+}
+
+LatencyMetrics::Summary LatencyMetrics::GetSummary() const {
+    Summary summary;
+    summary.count = count_.load(std::memory_order_relaxed);
+    if (summary.count == 0) {
+        return summary;
+    }
+    summary.mean_us = total_ns_.load(std::memory_order_relaxed) / 1000. / summary.count;
+    summary.p50_us = GetPercentile(summary.count, 0.5);
+    summary.p99_us = GetPercentile(summary.count, 0.99);
+    summary.max_us = max_ns_.load(std::memory_order_relaxed) / 1000.;
+    return summary;
+}
+
+TenantRegistry::TenantRegistry(ThreadPool& pool)
+    : pool_(pool)
+    , names_(std::make_shared<NameArena>()) {
+}
+
+void TenantRegistry::AddTenant(const std::string& key, const json::Node& tenant_data, size_t memory_limit) {
+    if (tenants_.contains(key)) {
+        throw TenantError("Tenant "s + key + " already exists"s);
+    }
+    auto tenant = std::make_unique<Tenant>(names_);
+    LoadCatalogueFromJson(tenant->catalogue, tenant_data);
+    tenant->render_settings = LoadRenderSettingsFromJson(tenant_data);
+    tenant->memory_limit = memory_limit;
+    tenant->memory_used = GetCatalogueMemoryUsage(tenant->catalogue);
+    if (tenant->memory_used > memory_limit) {
+        throw TenantError("Catalogue of tenant "s + key + " needs "s + std::to_string(tenant->memory_used)
+                          + " bytes, the limit is "s + std::to_string(memory_limit));
+    }
+    tenants_.emplace(key, std::move(tenant));
+}
+
+void TenantRegistry::RemoveTenant(const std::string& key) {
+    if (tenants_.erase(key) == 0) {
+        throw TenantError("Unknown tenant "s + key);
+    }
+}
+
+size_t TenantRegistry::GetTenantsCount() const {
+    return tenants_.size();
+}
+
+const TenantRegistry::Tenant& TenantRegistry::GetTenant(const std::string& key) const {
+    auto it = tenants_.find(key);
+    if (it == tenants_.end()) {
+        throw TenantError("Unknown tenant "s + key);
+    }
+    return *it->second;
+}
+
+size_t TenantRegistry::GetMemoryUsage(const std::string& key) const {
+    return GetTenant(key).memory_used;
+}
+
+LatencyMetrics::Summary TenantRegistry::GetLatency(const std::string& key) const {
+    return GetTenant(key).latency.GetSummary();
+}
+
+const NameArena& TenantRegistry::GetNames() const {
+    return *names_;
+}
+
+//Маршрутизаторы нужных арендаторов строятся параллельно до ответов на запросы.
+//Арендатор, которому матрица не по лимиту, остаётся без маршрутизатора.
+void TenantRegistry::BuildRoutesManagers(const json::Array& stat_requests) {
+    std::vector<Tenant*> tenants;
+    for (const json::Node& request : stat_requests) {
+        if (!NeedsRoutesManager(request) || !request.AsMap().contains("tenant")) {
+            continue;
+        }
+        auto it = tenants_.find(std::string(request.AsMap().at("tenant").AsString()));
+        if (it == tenants_.end() || it->second->routes_manager) {
+            continue;
+        }
+        Tenant* tenant = it->second.get();
+        const size_t router_memory = graph::RoutesManager::EstimateMemoryUsage(tenant->catalogue);
+        if (router_memory > tenant->memory_limit - tenant->memory_used || std::find(tenants.begin(), tenants.end(), tenant) != tenants.end()) {
+            continue;
+        }
+        tenant->memory_used += router_memory;
+        tenants.push_back(tenant);
+    }
+    std::vector<std::future<void>> builds;
+    for (Tenant* tenant : tenants) {
+        builds.push_back(pool_.Submit([tenant] { tenant->routes_manager.emplace(tenant->catalogue); }));
+    }
+    for (auto& build : builds) {
+        build.get();
+    }
+}
+
+void TenantRegistry::MakeAnswer(const json::Node& catalogue_data, const json::Node& request, json::Builder& builder, std::pmr::memory_resource* resource) {
+    const auto& request_map = request.AsMap();
+    auto it = request_map.contains("tenant") ? tenants_.find(std::string(request_map.at("tenant").AsString())) : tenants_.end();
+    if (it == tenants_.end()) {
+        MakeErrorAnswer(request, "unknown tenant"sv, builder);
+        return;
+    }
+    Tenant& tenant = *it->second;
+    if (request_map.at("type").AsString() == "TenantStats") {
+        const LatencyMetrics::Summary latency = tenant.latency.GetSummary();
+        builder.StartDict().Key("request_id").Value(request_map.at("id").AsInt())
+            .Key("requests").Value(MakeSizeValue(latency.count))
+            .Key("mean_latency_us").Value(latency.mean_us)
+            .Key("p50_latency_us").Value(latency.p50_us)
+            .Key("p99_latency_us").Value(latency.p99_us)
+            .Key("max_latency_us").Value(latency.max_us)
+            .Key("memory_bytes").Value(MakeSizeValue(tenant.memory_used));
+        if (tenant.memory_limit != SIZE_MAX) {
+            builder.Key("memory_limit").Value(MakeSizeValue(tenant.memory_limit));
+        }
+        builder.EndDict();
+        return;
+    }
+    const auto start = std::chrono::steady_clock::now();
+    if (NeedsRoutesManager(request) && !tenant.routes_manager) {
+        MakeErrorAnswer(request, "memory limit exceeded"sv, builder);
+    }
+    else {
+        transport_catalogue::MakeAnswer(tenant.catalogue, tenant.routes_manager, tenant.render_settings, catalogue_data, request, builder, resource);
+    }
+    tenant.latency.Record(std::chrono::steady_clock::now() - start);
+}
+
+json::Document TenantRegistry::ParseAndMakeAnswers(const json::Node& catalogue_data) {
+    const auto& stat_requests = catalogue_data.AsMap().at("stat_requests").AsArray();
+    BuildRoutesManagers(stat_requests);
+    //Несколько кусков на поток, как и для одного каталога
+    const size_t chunk_size = std::max<size_t>(1, stat_requests.size() / (4 * pool_.GetThreadsCount()));
+    json::DocumentArenas answers_arenas;
+    std::vector<std::future<json::Array>> chunks;
+    for (size_t begin = 0; begin < stat_requests.size(); begin += chunk_size) {
+        const size_t end = std::min(begin + chunk_size, stat_requests.size());
+        chunks.push_back(pool_.Submit([&, begin, end, resource = answers_arenas.Add()] {
+            json::Builder builder(resource);
+            ScratchArena& arena = GetThreadScratchArena();
+            builder.StartArray();
+            for (size_t i = begin; i < end; ++i) {
+                MakeAnswer(catalogue_data, stat_requests[i], builder, arena.GetResource());
+                arena.Reset();
+            }
+            json::Node answers = builder.EndArray().Build();
+            return std::move(std::get<json::Array>(answers.GetValue()));
+        }));
+    }
+    return JoinChunks(chunks, std::move(answers_arenas), stat_requests.size());
+}
+
+json::Document TenantRegistry::LoadAndMakeAnswers(const json::Node& catalogue_data) {
+    for (const json::Node& tenant_data : catalogue_data.AsMap().at("tenants").AsArray()) {
+        const auto& tenant_map = tenant_data.AsMap();
+        std::string key(tenant_map.at("name").AsString());
+        size_t memory_limit = SIZE_MAX;
+        if (tenant_map.contains("memory_limit")) {
+            //Приведение отрицательного, NaN или не меньшего 2^64 числа к size_t не определено
+            const double limit = tenant_map.at("memory_limit").AsDouble();
+            if (!(limit >= 0 && limit < static_cast<double>(SIZE_MAX))) {
+                throw TenantError("Invalid memory limit of tenant "s + key);
+            }
+            memory_limit = static_cast<size_t>(limit);
+        }
+        AddTenant(key, tenant_data, memory_limit);
+    }
+    return ParseAndMakeAnswers(catalogue_data);
+}
+
+} //transport_catalogue
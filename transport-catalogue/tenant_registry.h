@@ -0,0 +1,106 @@
+#pragma once
+
+#include "json.h"
+#include "json_builder.h"
+#include "map_renderer.h"
+#include "name_arena.h"
+#include "thread_pool.h"
+#include "transport_catalogue.h"
+#include "transport_router.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+
+namespace transport_catalogue {
+
+//Ошибка управления арендаторами: повторный или неизвестный ключ, превышение лимита памяти
+class TenantError : public std::runtime_error {
+public:
+    using runtime_error::runtime_error;
+};
+
+//Задержки запросов: счётчики и гистограмма по степеням двойки микросекунд.
+//Пишется из потоков пула без блокировок.
+class LatencyMetrics {
+public:
+    struct Summary {
+        uint64_t count = 0;
+        double mean_us = 0.;
+        double p50_us = 0.; //Верхняя граница корзины гистограммы
+        double p99_us = 0.;
+        double max_us = 0.;
+    };
+
+    void Record(std::chrono::nanoseconds latency);
+    Summary GetSummary() const;
+
+private:
+    static constexpr size_t BUCKETS_COUNT = 40;
+
+    double GetPercentile(uint64_t count, double share) const;
+
+    std::atomic<uint64_t> count_{0};
+    std::atomic<uint64_t> total_ns_{0};
+    std::atomic<uint64_t> max_ns_{0};
+    std::array<std::atomic<uint64_t>, BUCKETS_COUNT> buckets_{};
+};
+
+//Каталоги нескольких городов в одном процессе. Арендаторы делят пул потоков и арену имён,
+//у каждого свой каталог, маршрутизатор, лимит памяти и метрики задержек.
+//Маршрутизатор строится при первом запросе Route или Memory, если укладывается в лимит.
+//Добавлять и удалять арендаторов можно только между вызовами ParseAndMakeAnswers.
+//Арена имён только растёт: имена удалённого арендатора в ней остаются, потому что их могут
+//делить другие арендаторы. Повторная загрузка тех же имён её не увеличивает, поэтому арена
+//ограничена числом разных имён, когда-либо загруженных в реестр.
+class TenantRegistry {
+public:
+    explicit TenantRegistry(ThreadPool& pool);
+
+    //tenant_data содержит base_requests, routing_settings и, если нужно, render_settings.
+    //Лимит считается по каталогу и матрице маршрутизатора без общей арены имён.
+    void AddTenant(const std::string& key, const json::Node& tenant_data, size_t memory_limit = SIZE_MAX);
+    void RemoveTenant(const std::string& key); //Имена арендатора остаются в общей арене
+    size_t GetTenantsCount() const;
+    size_t GetMemoryUsage(const std::string& key) const;
+    LatencyMetrics::Summary GetLatency(const std::string& key) const;
+    const NameArena& GetNames() const;
+
+    //Запрос выбирает арендатора ключом "tenant". Кроме обычных запросов есть TenantStats
+    //с задержками и памятью арендатора: запросы пакета обрабатываются параллельно,
+    //поэтому TenantStats учитывает только уже отвеченные. Ответы идут в порядке запросов.
+    json::Document ParseAndMakeAnswers(const json::Node& catalogue_data);
+    //Загружает арендаторов из массива "tenants" и отвечает на "stat_requests"
+    json::Document LoadAndMakeAnswers(const json::Node& catalogue_data);
+
+private:
+    struct Tenant {
+        explicit Tenant(std::shared_ptr<NameArena> names)
+            : catalogue(std::move(names)) {
+        }
+
+        TransportCatalogue catalogue;
+        std::optional<RenderSettings> render_settings;
+        std::optional<graph::RoutesManager> routes_manager;
+        size_t memory_limit = SIZE_MAX;
+        size_t memory_used = 0;
+        LatencyMetrics latency;
+    };
+
+    const Tenant& GetTenant(const std::string& key) const;
+    void BuildRoutesManagers(const json::Array& stat_requests);
+    void MakeAnswer(const json::Node& catalogue_data, const json::Node& request, json::Builder& builder, std::pmr::memory_resource* resource);
+
+    ThreadPool& pool_;
+    std::shared_ptr<NameArena> names_;
+    std::unordered_map<std::string, std::unique_ptr<Tenant>> tenants_;
+};
+
+} //transport_catalogue
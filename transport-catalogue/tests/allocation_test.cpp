@@ -0,0 +1,130 @@
+//Повторные запросы Bus, Stop и Route не обращаются к куче: временные структуры запроса
+//берутся из арены запроса, ответы - из арены документа, а ключи ответов из общей таблицы.
+//Сборка из каталога transport-catalogue:
+//g++ -std=c++20 -pthread -I. -o allocation_test tests/allocation_test.cpp $(ls *.cpp | grep -v main.cpp)
+
+#include "json.h"
+#include "json_builder.h"
+#include "json_reader.h"
+#include "scratch_arena.h"
+#include "transport_catalogue.h"
+#include "transport_router.h"
+
+#include <atomic>
+#include <cassert>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <optional>
+#include <string_view>
+
+namespace {
+
+std::atomic<size_t> allocations_count{0};
+
+void* CountedAllocate(std::size_t size, std::size_t alignment) {
+    ++allocations_count;
+    void* data = alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__
+        ? std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment)
+        : std::malloc(size == 0 ? 1 : size);
+    if (data == nullptr) {
+        throw std::bad_alloc();
+    }
+    return data;
+}
+
+} //namespace
+
+void* operator new(std::size_t size) {
+    return CountedAllocate(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    return CountedAllocate(size, static_cast<std::size_t>(alignment));
+}
+void operator delete(void* data) noexcept {
+    std::free(data);
+}
+void operator delete(void* data, std::size_t) noexcept {
+    std::free(data);
+}
+void operator delete(void* data, std::align_val_t) noexcept {
+    std::free(data);
+}
+void operator delete(void* data, std::size_t, std::align_val_t) noexcept {
+    std::free(data);
+}
+
+using namespace std::literals;
+using namespace transport_catalogue;
+
+namespace {
+
+//Имена длиннее буфера короткой строки: их копия в std::string выделила бы память
+const char* const REQUESTS = R"({
+    "base_requests": [
+        {"type": "Stop", "name": "Улица Академика Королёва", "latitude": 55.60, "longitude": 37.60, "road_distances": {"Останкинская телебашня": 1200}},
+        {"type": "Stop", "name": "Останкинская телебашня", "latitude": 55.61, "longitude": 37.61, "road_distances": {"Улица Академика Королёва": 1300, "ВДНХ": 900}},
+        {"type": "Stop", "name": "ВДНХ", "latitude": 55.62, "longitude": 37.62, "road_distances": {}},
+        {"type": "Bus", "name": "Экспресс-маршрут 101", "stops": ["Улица Академика Королёва", "Останкинская телебашня", "ВДНХ"], "is_roundtrip": false},
+        {"type": "Bus", "name": "Кольцевой маршрут 24", "stops": ["ВДНХ", "Останкинская телебашня", "ВДНХ"], "is_roundtrip": true}
+    ],
+    "routing_settings": {"bus_velocity": 40, "bus_wait_time": 6},
+    "stat_requests": [
+        {"id": 1, "type": "Stop", "name": "Останкинская телебашня"},
+        {"id": 2, "type": "Stop", "name": "Нет такой остановки"},
+        {"id": 3, "type": "Route", "from": "Улица Академика Королёва", "to": "ВДНХ"},
+        {"id": 4, "type": "Route", "from": "ВДНХ", "to": "Улица Академика Королёва"},
+        {"id": 5, "type": "Bus", "name": "Экспресс-маршрут 101"}
+    ]
+})";
+
+constexpr size_t ROUNDS_COUNT = 100;
+constexpr size_t ANSWERS_ARENA_SIZE = 16 << 20; //Хватает всем ответам теста без новых блоков
+
+void TestRepeatedRequestsDoNotAllocate() {
+    const json::Document input = json::Load(std::string_view(REQUESTS));
+    TransportCatalogue catalogue;
+    LoadCatalogueFromJson(catalogue, input.GetRoot());
+    std::optional<graph::RoutesManager> routes_manager;
+    routes_manager.emplace(catalogue);
+    const std::optional<RenderSettings> render_settings;
+    const json::Array& stat_requests = input.GetRoot().AsMap().at("stat_requests").AsArray();
+
+    json::DocumentArenas answers_arenas;
+    json::Builder builder(answers_arenas.Add(ANSWERS_ARENA_SIZE));
+    ScratchArena arena;
+    const auto answer_all = [&] {
+        for (const json::Node& request : stat_requests) {
+            MakeAnswer(catalogue, routes_manager, render_settings, input.GetRoot(), request, builder, arena.GetResource());
+            arena.Reset();
+        }
+    };
+    builder.StartArray();
+    //Первый проход заполняет ленивые кэши каталога и стек построителя
+    answer_all();
+    const size_t allocations_before = allocations_count;
+    for (size_t i = 0; i < ROUNDS_COUNT; ++i) {
+        answer_all();
+    }
+    assert(allocations_count == allocations_before);
+
+    const json::Document answers = std::move(answers_arenas).MakeDocument(builder.EndArray().Build());
+    const json::Array& array = answers.GetRoot().AsArray();
+    assert(array.size() == (ROUNDS_COUNT + 1) * stat_requests.size());
+    const json::Dict& last_stop = array[array.size() - 5].AsMap();
+    assert(last_stop.at("buses").AsArray().size() == 2);
+    assert(last_stop.at("buses").AsArray()[1].AsString() == "Экспресс-маршрут 101"sv);
+    assert(array[array.size() - 4].AsMap().at("error_message").AsString() == "not found"sv);
+    const json::Array& items = array[array.size() - 3].AsMap().at("items").AsArray();
+    assert(items.size() == 2);
+    assert(items[0].AsMap().at("stop_name").AsString() == "Улица Академика Королёва"sv);
+    assert(items[1].AsMap().at("bus").AsString() == "Экспресс-маршрут 101"sv);
+    assert(array.back().AsMap().at("stop_count").AsInt() == 5);
+}
+
+} //namespace
+
+int main() {
+    TestRepeatedRequestsDoNotAllocate();
+    std::cout << "allocation_test: OK"sv << std::endl;
+}
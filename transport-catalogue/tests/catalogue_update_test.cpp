@@ -0,0 +1,188 @@
+//Удаление остановок и маршрутов и перенумерация последних на место удалённых.
+//Сборка из каталога transport-catalogue:
+//g++ -std=c++20 -pthread -I. -o catalogue_update_test tests/catalogue_update_test.cpp $(ls *.cpp | grep -v main.cpp)
+
+#include "catalogue_versions.h"
+#include "json_reader.h"
+#include "transport_catalogue.h"
+
+#include <cassert>
+#include <iostream>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std::literals;
+using namespace transport_catalogue;
+
+namespace {
+
+std::vector<std::string_view> GetBusStopsNames(const TransportCatalogue& catalogue, std::string_view bus_name) {
+    std::vector<std::string_view> names;
+    for (StopId stop : catalogue.GetBusStops(*catalogue.FindBus(bus_name))) {
+        names.push_back(catalogue.GetStops()[stop].name);
+    }
+    return names;
+}
+
+std::set<std::string_view> GetBusesForStop(const TransportCatalogue& catalogue, std::string_view stop_name) {
+    const auto buses = catalogue.GetBusesForStop(stop_name).value();
+    return {buses.begin(), buses.end()};
+}
+
+//A, B, C, D с номерами 0..3; маршрут X - B, C, D, маршрут Y - C, D, маршрут Z - D, C
+TransportCatalogue MakeCatalogue() {
+    TransportCatalogue catalogue;
+    catalogue.AddStop("A"sv, {55.60, 37.60});
+    catalogue.AddStop("B"sv, {55.61, 37.61});
+    catalogue.AddStop("C"sv, {55.62, 37.62});
+    catalogue.AddStop("D"sv, {55.63, 37.63});
+    catalogue.AddDistance("A"sv, "D"sv, 500);
+    catalogue.AddDistance("B"sv, "C"sv, 1000);
+    catalogue.AddDistance("C"sv, "D"sv, 1500);
+    catalogue.AddDistance("D"sv, "C"sv, 1700);
+    catalogue.AddDistance("D"sv, "D"sv, 100);
+    catalogue.AddBus("X"sv, std::vector<std::string_view>{"B"sv, "C"sv, "D"sv}, false);
+    catalogue.AddBus("Y"sv, std::vector<std::string_view>{"C"sv, "D"sv}, true);
+    catalogue.AddBus("Z"sv, std::vector<std::string_view>{"D"sv, "C"sv}, false);
+    catalogue.BuildIndexes();
+    return catalogue;
+}
+
+//Последняя остановка D получает номер удалённой A вместе с расстояниями, маршрутами и индексами
+void TestRemoveStopRenumbersLastStop() {
+    TransportCatalogue catalogue = MakeCatalogue();
+    const TransportCatalogue before = catalogue;
+    const BusInfo x_info = *catalogue.GetBusInfo("X"sv);
+    catalogue.RemoveStop("A"sv);
+
+    assert(catalogue.GetStops().size() == 3);
+    assert(catalogue.FindStop("A"sv) == nullptr);
+    assert(catalogue.FindStop("D"sv)->id == 0);
+    assert(catalogue.GetStops()[0].name == "D"sv);
+    assert(catalogue.GetStops()[0].coordinates == (Coordinates{55.63, 37.63}));
+    assert(catalogue.GetDistance("C"sv, "D"sv) == 1500);
+    assert(catalogue.GetDistance("D"sv, "C"sv) == 1700);
+    assert(catalogue.GetDistance("D"sv, "D"sv) == 100);
+    assert(catalogue.GetDistance(StopId{0}, StopId{0}) == 100);
+    assert(!catalogue.GetDistance(StopId{0}, StopId{1}).has_value()); //Номер 1 - по-прежнему B
+    assert(catalogue.GetDistances().Size() == 5);
+
+    assert(GetBusStopsNames(catalogue, "X"sv) == (std::vector{"B"sv, "C"sv, "D"sv}));
+    assert(GetBusStopsNames(catalogue, "Z"sv) == (std::vector{"D"sv, "C"sv}));
+    assert(GetBusesForStop(catalogue, "D"sv) == (std::set{"X"sv, "Y"sv, "Z"sv}));
+    assert(catalogue.GetBusInfo("X"sv)->length == x_info.length);
+
+    const auto nearest = catalogue.NearestStops({55.63, 37.63}, 1);
+    assert(nearest.size() == 1 && nearest[0].first->name == "D"sv && nearest[0].first->id == 0);
+    assert(catalogue.SuggestStops("a"sv, 10).empty());
+    assert(catalogue.SuggestStops("d"sv, 10) == std::vector{"D"sv});
+
+    //Копия до удаления его не видит
+    assert(before.GetStops().size() == 4);
+    assert(before.FindStop("D"sv)->id == 3);
+    assert(before.GetDistance("A"sv, "D"sv) == 500);
+    assert(GetBusStopsNames(before, "X"sv) == (std::vector{"B"sv, "C"sv, "D"sv}));
+    assert(before.SuggestStops("a"sv, 10) == std::vector{"A"sv});
+}
+
+void TestRemoveStopErrors() {
+    TransportCatalogue catalogue = MakeCatalogue();
+    bool is_thrown = false;
+    try {
+        catalogue.RemoveStop("C"sv);
+    }
+    catch (const std::invalid_argument&) {
+        is_thrown = true;
+    }
+    assert(is_thrown);
+    is_thrown = false;
+    try {
+        catalogue.RemoveStop("E"sv);
+    }
+    catch (const std::out_of_range&) {
+        is_thrown = true;
+    }
+    assert(is_thrown);
+    assert(catalogue.GetStops().size() == 4);
+}
+
+//Последний маршрут Z получает номер удалённого X
+void TestRemoveBusRenumbersLastBus() {
+    TransportCatalogue catalogue = MakeCatalogue();
+    const BusInfo z_info = *catalogue.GetBusInfo("Z"sv);
+    catalogue.RemoveBus("X"sv);
+
+    assert(catalogue.GetBuses().size() == 2);
+    assert(catalogue.FindBus("X"sv) == nullptr);
+    assert(catalogue.GetBuses()[0].name == "Z"sv);
+    assert(catalogue.FindBus("Z"sv) == &catalogue.GetBuses()[0]);
+    assert(GetBusStopsNames(catalogue, "Z"sv) == (std::vector{"D"sv, "C"sv}));
+    assert(catalogue.GetBusInfo("Z"sv)->length == z_info.length);
+    assert(GetBusesForStop(catalogue, "B"sv).empty());
+    assert(GetBusesForStop(catalogue, "C"sv) == (std::set{"Y"sv, "Z"sv}));
+    assert(catalogue.SuggestBuses("x"sv, 10).empty());
+    assert(catalogue.SuggestBuses("z"sv, 10) == std::vector{"Z"sv});
+    assert(catalogue.GetAllBusesInfo().names == (std::vector{"Y"sv, "Z"sv}));
+
+    //Через B больше не проходят маршруты, поэтому её можно удалить
+    catalogue.RemoveStop("B"sv);
+    assert(catalogue.FindStop("D"sv)->id == 1);
+    assert(GetBusStopsNames(catalogue, "Y"sv) == (std::vector{"C"sv, "D"sv}));
+    assert(catalogue.GetBusInfo("Z"sv)->length == z_info.length);
+}
+
+const char* const UPDATE_REQUESTS = R"({
+    "base_requests": [
+        {"type": "Stop", "name": "A", "latitude": 55.60, "longitude": 37.60, "road_distances": {"B": 1000}},
+        {"type": "Stop", "name": "B", "latitude": 55.61, "longitude": 37.61, "road_distances": {"C": 1000}},
+        {"type": "Stop", "name": "C", "latitude": 55.62, "longitude": 37.62, "road_distances": {}},
+        {"type": "Bus", "name": "X", "stops": ["A", "B"], "is_roundtrip": false},
+        {"type": "Bus", "name": "Y", "stops": ["B", "C"], "is_roundtrip": false}
+    ],
+    "routing_settings": {"bus_velocity": 40, "bus_wait_time": 6},
+    "stat_requests": [
+        {"id": 1, "type": "Update", "base_requests": [{"type": "RemoveStop", "name": "B"}]},
+        {"id": 2, "type": "Update", "base_requests": [{"type": "RemoveBus", "name": "X"}, {"type": "RemoveStop", "name": "A"}]},
+        {"id": 3, "type": "Bus", "name": "X"},
+        {"id": 4, "type": "Stop", "name": "A"},
+        {"id": 5, "type": "Stop", "name": "C"},
+        {"id": 6, "type": "Bus", "name": "Y"},
+        {"id": 7, "type": "Update", "base_requests": [{"type": "RemoveBus", "name": "X"}]}
+    ]
+})";
+
+//Неудачное обновление не публикуется; удалённые имена больше не находятся
+void TestUpdateRequestRemoves() {
+    const json::Document input = json::Load(std::string_view(UPDATE_REQUESTS));
+    TransportCatalogue catalogue;
+    LoadCatalogueFromJson(catalogue, input.GetRoot());
+    CatalogueVersions versions(std::move(catalogue));
+    const json::Document answers = ParseAndMakeAnswers(versions, std::nullopt, input.GetRoot());
+    const json::Array& array = answers.GetRoot().AsArray();
+    assert(array.size() == 7);
+    assert(array[0].AsMap().at("error_message").AsString() == "invalid update"sv);
+    assert(array[1].AsMap().at("version").AsInt() == 1);
+    assert(array[2].AsMap().at("error_message").AsString() == "not found"sv);
+    assert(array[3].AsMap().at("error_message").AsString() == "not found"sv);
+    assert(array[4].AsMap().at("buses").AsArray().size() == 1);
+    assert(array[5].AsMap().at("stop_count").AsInt() == 3);
+    assert(array[6].AsMap().at("error_message").AsString() == "invalid update"sv);
+
+    const TransportCatalogue& current = versions.Get()->catalogue;
+    assert(current.GetStops().size() == 2);
+    assert(current.FindStop("C"sv)->id == 0); //Последняя C заняла место A
+    assert(current.GetDistance("B"sv, "C"sv) == 1000);
+}
+
+} //namespace
+
+int main() {
+    TestRemoveStopRenumbersLastStop();
+    TestRemoveStopErrors();
+    TestRemoveBusRenumbersLastBus();
+    TestUpdateRequestRemoves();
+    std::cout << "catalogue_update_test: OK"sv << std::endl;
+}
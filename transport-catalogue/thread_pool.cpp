@@ -0,0 +1,97 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+
+namespace transport_catalogue {
+
+namespace {
+
+//Номер потока пула, в котором выполняется код; у внешних потоков его нет
+thread_local const ThreadPool* current_pool = nullptr;
+thread_local size_t current_worker = 0;
+
+} //namespace
+
+ThreadPool::ThreadPool(size_t threads_count) {
+    threads_count = std::max<size_t>(threads_count, 1);
+    for (size_t i = 0; i < threads_count; ++i) {
+        workers_.push_back(std::make_unique<Worker>());
+    }
+    for (size_t i = 0; i < threads_count; ++i) {
+        threads_.emplace_back([this, i] { Run(i); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard lock(wake_mutex_);
+        stop_ = true;
+    }
+    wake_.notify_all();
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+}
+
+size_t ThreadPool::GetThreadsCount() const {
+    return threads_.size();
+}
+
+void ThreadPool::Push(std::function<void()> task) {
+    //Задачи, порождённые внутри пула, остаются у того же потока
+    const size_t index = current_pool == this ? current_worker : next_worker_++ % workers_.size();
+    //Счётчик увеличивается до публикации задачи, чтобы не уйти в минус при её немедленной краже
+    ++pending_;
+    {
+        std::lock_guard lock(workers_[index]->mutex);
+        workers_[index]->tasks.push_back(std::move(task));
+    }
+    {
+        std::lock_guard lock(wake_mutex_);
+    }
+    wake_.notify_one();
+}
+
+bool ThreadPool::TryPop(size_t index, std::function<void()>& task) {
+    {
+        Worker& own = *workers_[index];
+        std::lock_guard lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            --pending_;
+            return true;
+        }
+    }
+    for (size_t shift = 1; shift < workers_.size(); ++shift) {
+        Worker& victim = *workers_[(index + shift) % workers_.size()];
+        std::lock_guard lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            --pending_;
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::Run(size_t index) {
+    current_pool = this;
+    current_worker = index;
+    std::function<void()> task;
+    while (true) {
+        if (TryPop(index, task)) {
+            task();
+            task = nullptr;
+            continue;
+        }
+        std::unique_lock lock(wake_mutex_);
+        wake_.wait(lock, [this] { return stop_ || pending_ > 0; });
+        if (stop_ && pending_ == 0) {
+            return;
+        }
+    }
+}
+
+} //transport_catalogue
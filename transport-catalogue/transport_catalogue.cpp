@@ -3,8 +3,10 @@
 #include <algorithm>
 #include <optional>
 #include <set>
+#include <stdexcept>
 #include <string>
 #include <string_view>
+#include <type_traits>
 #include <unordered_set>
 #include <vector>
 #include <cassert>
@@ -12,37 +14,309 @@
 
 namespace transport_catalogue {
 
-std::optional<int> TransportCatalogue::GetDistance(const std::string_view stop1_name, const std::string_view stop2_name) const {
-    auto stop1_it = stops_names.find(stop1_name);
-    assert(stop1_it != stops_names.end());
-    auto stop2_it = stops_names.find(stop2_name);
-    assert(stop2_it != stops_names.end());
-    auto it = distances_.find({stop1_it->second, stop2_it->second});
-    if (it == distances_.end()) {
-        it = distances_.find({stop2_it->second, stop1_it->second});
-    }
-    if (it == distances_.end()) {
-        return std::nullopt;
+using namespace std::literals;
+
+namespace {
+
+//Подсказки без индекса: подходящие имена собираются перебором и сортируются временным индексом
+template <typename Items>
+std::vector<std::string_view> FindNamesByPrefix(const Items& items, std::string_view prefix, size_t limit) {
+    const std::string key = FoldName(prefix);
+    std::vector<std::string_view> names;
+    for (const auto& item : items) {
+        if (FoldName(item.name).starts_with(key)) {
+            names.push_back(item.name);
+        }
+    }
+    NameIndex index;
+    index.Build(names);
+    return index.FindByPrefix(prefix, limit);
+}
+
+//Номер объекта по имени в таблице или, после заморозки, по позиции совершенного хеша
+template <typename Names, typename Items>
+std::optional<uint32_t> FindId(const Names& names, const Items& items, std::string_view name) {
+    if (names.frozen != nullptr) {
+        if (names.frozen->by_slot.empty()) {
+            return std::nullopt;
+        }
+        const uint32_t id = names.frozen->by_slot[names.frozen->hash.Find(name)];
+        return items[id].name == name ? std::optional<uint32_t>(id) : std::nullopt;
     }
-    return it->second;
+    const uint32_t* id = names.ids.Find(name);
+    return id != nullptr ? std::optional<uint32_t>(*id) : std::nullopt;
+}
+
+template <typename Names, typename Items>
+void FreezeIds(Names& names, const Items& items) {
+    std::vector<std::string_view> keys;
+    keys.reserve(items.size());
+    for (const auto& item : items) {
+        keys.push_back(item.name);
+    }
+    auto frozen = std::make_shared<std::remove_const_t<typename decltype(names.frozen)::element_type>>();
+    frozen->hash.Build(keys);
+    frozen->by_slot.resize(items.size());
+    for (uint32_t id = 0; id < items.size(); ++id) {
+        frozen->by_slot[frozen->hash.Find(items[id].name)] = id;
+    }
+    names.frozen = std::move(frozen);
+    names.ids.clear();
+}
+
+template <typename Names, typename Items>
+void UnfreezeIds(Names& names, const Items& items) {
+    names.ids.reserve(items.size());
+    for (uint32_t id = 0; id < items.size(); ++id) {
+        names.ids.Set(items[id].name, id);
+    }
+    names.frozen = nullptr;
+}
+
+template <typename Names>
+memory::Usage GetNamesMemoryUsage(std::string name, const Names& names) {
+    if (names.frozen != nullptr) {
+        return {std::move(name), names.frozen->hash.GetMemoryUsage().bytes + memory::VectorBytes(names.frozen->by_slot), names.frozen->by_slot.size()};
+    }
+    memory::Usage usage = names.ids.GetMemoryUsage();
+    usage.name = std::move(name);
+    return usage;
+}
+
+} //namespace
+
+TransportCatalogue::TransportCatalogue()
+    : names_(std::make_shared<NameArena>()) {
+}
+
+TransportCatalogue::TransportCatalogue(std::shared_ptr<NameArena> names)
+    : names_(std::move(names)) {
+}
+
+std::optional<int> TransportCatalogue::GetDistance(const std::string_view stop1_name, const std::string_view stop2_name) const {
+    const std::optional<StopId> stop1 = FindStopId(stop1_name);
+    assert(stop1.has_value());
+    const std::optional<StopId> stop2 = FindStopId(stop2_name);
+    assert(stop2.has_value());
+    return GetDistance(*stop1, *stop2);
+}
+
+std::optional<int> TransportCatalogue::GetDistance(StopId stop1, StopId stop2) const {
+    return distances_.Get(stop1, stop2);
+}
+
+double TransportCatalogue::ComputeGeoDistance(StopId stop1, StopId stop2) const {
+    return ComputeUnitDistance(GetUnitVector(stop1), GetUnitVector(stop2));
+}
+
+UnitVector TransportCatalogue::GetUnitVector(StopId stop) const {
+    return {stops_x_[stop], stops_y_[stop], stops_z_[stop]};
 }
     
 void TransportCatalogue::AddDistance(const std::string_view stop1_name, const std::string_view stop2_name, int distance) {
-    distances_[{stops_names[stop1_name], stops_names[stop2_name]}] = distance;
-}    
+    AddDistance(GetStopId(stop1_name), GetStopId(stop2_name), distance);
+}
+
+void TransportCatalogue::AddDistance(StopId stop1, StopId stop2, int distance) {
+    if (stop1 >= stops_.size()) {
+        throw std::out_of_range("Unknown stop id "s + std::to_string(stop1));
+    }
+    distances_.Set(stop1, stop2, distance);
+    //Пересчитываем статистику уже добавленных маршрутов, проходящих через остановку
+    UpdateBusesInfo(stop1);
+}
+
+void TransportCatalogue::UpdateBusesInfo(StopId stop) {
+    for (BusId bus : stop_buses_[stop]) {
+        const BusInfo info = ComputeBusInfo(buses_[bus]);
+        buses_.Mutable(bus).info = info;
+    }
+}
     
-void TransportCatalogue::AddBus(std::string bus_name, const std::vector<std::string_view>& stops) {
-    std::vector<Stop*> bus_stops;
+void TransportCatalogue::AddBus(std::string_view bus_name, const std::vector<std::string_view>& stops, bool is_roundtrip) {
+    std::vector<StopId> bus_stops;
     for (auto& stop: stops) { 
-        bus_stops.push_back(stops_names[stop]);
+        bus_stops.push_back(GetStopId(stop));
+    }
+    AddBus(bus_name, bus_stops, is_roundtrip);
+}
+
+//Повторное добавление маршрута заменяет его остановки
+void TransportCatalogue::AddBus(std::string_view bus_name, const std::vector<StopId>& stops, bool is_roundtrip) {
+    if (const std::optional<BusId> bus = FindBusId(bus_name)) {
+        SetBusStops(*bus, stops, is_roundtrip);
+        return;
+    }
+    UnfreezeBusesNames();
+    const bool is_index_current = IsBusesIndexCurrent();
+    const BusId id = static_cast<BusId>(buses_.size());
+    buses_.push_back({names_->Get(names_->Intern(bus_name)), stop_sequences_.Add({}), is_roundtrip, {}});
+    const std::string_view name = buses_.back().name;
+    buses_names_.ids.Set(name, id);
+    if (is_index_current) {
+        buses_index_.Insert(name);
     }
-    buses_.push_back({std::move(bus_name), std::move(bus_stops)});
-    buses_names[buses_.back().name] = &buses_.back();
+    SetBusStops(id, stops, is_roundtrip);
 }
 
-void TransportCatalogue::AddStop(std::string stop_name, const Coordinates& stop_coord) {
-    stops_.push_back({std::move(stop_name), stop_coord}); 
-    stops_names[stops_.back().name] = &stops_.back();
+void TransportCatalogue::SetBusStops(BusId bus, const std::vector<StopId>& stops, bool is_roundtrip) {
+    for (StopId stop : stops) {
+        if (stop >= stops_.size()) {
+            throw std::out_of_range("Unknown stop id "s + std::to_string(stop));
+        }
+    }
+    UnindexBus(bus);
+    stop_sequences_.Set(buses_[bus].stops, stops);
+    Bus& bus_data = buses_.Mutable(bus);
+    bus_data.is_roundtrip = is_roundtrip;
+    bus_data.info = ComputeBusInfo(bus_data);
+    for (StopId stop : stops) {
+        std::vector<BusId>& stop_buses = stop_buses_.Mutable(stop);
+        if (std::find(stop_buses.begin(), stop_buses.end(), bus) == stop_buses.end()) {
+            stop_buses.push_back(bus);
+        }
+    }
+}
+
+void TransportCatalogue::UnindexBus(BusId bus) {
+    for (StopId stop : stop_sequences_.Get(buses_[bus].stops)) {
+        const std::vector<BusId>& stop_buses = stop_buses_[stop];
+        if (std::find(stop_buses.begin(), stop_buses.end(), bus) != stop_buses.end()) {
+            std::vector<BusId>& mutable_buses = stop_buses_.Mutable(stop);
+            mutable_buses.erase(std::find(mutable_buses.begin(), mutable_buses.end(), bus));
+        }
+    }
+}
+
+void TransportCatalogue::UpdateBusStops(std::string_view bus_name, const std::vector<std::string_view>& stops, bool is_roundtrip) {
+    std::vector<StopId> bus_stops;
+    for (auto& stop : stops) {
+        bus_stops.push_back(GetStopId(stop));
+    }
+    UpdateBusStops(bus_name, bus_stops, is_roundtrip);
+}
+
+void TransportCatalogue::UpdateBusStops(std::string_view bus_name, const std::vector<StopId>& stops, bool is_roundtrip) {
+    SetBusStops(GetBusId(bus_name), stops, is_roundtrip);
+}
+
+//Последний маршрут переносится на место удалённого и получает его номер
+void TransportCatalogue::RemoveBus(std::string_view bus_name) {
+    const BusId id = GetBusId(bus_name);
+    UnfreezeBusesNames();
+    UnindexBus(id);
+    const std::string_view name = buses_[id].name;
+    if (IsBusesIndexCurrent()) {
+        buses_index_.Erase(name);
+    }
+    buses_names_.ids.Erase(name);
+    stop_sequences_.Erase(buses_[id].stops);
+    const BusId last_id = static_cast<BusId>(buses_.size() - 1);
+    if (id != last_id) {
+        UnindexBus(last_id);
+        const Bus last = buses_[last_id];
+        buses_.Mutable(id) = last;
+        buses_names_.ids.Set(buses_[id].name, id);
+        for (StopId stop : stop_sequences_.Get(buses_[id].stops)) {
+            std::vector<BusId>& stop_buses = stop_buses_.Mutable(stop);
+            if (std::find(stop_buses.begin(), stop_buses.end(), id) == stop_buses.end()) {
+                stop_buses.push_back(id);
+            }
+        }
+    }
+    buses_.pop_back();
+}
+
+void TransportCatalogue::AddStop(std::string_view stop_name, const Coordinates& stop_coord) {
+    UnfreezeStopsNames();
+    const bool is_index_current = IsSpatialIndexCurrent();
+    const bool is_names_index_current = IsStopsIndexCurrent();
+    const StopId id = static_cast<StopId>(stops_.size());
+    stops_.push_back({names_->Get(names_->Intern(stop_name)), stop_coord, id});
+    const std::string_view name = stops_.back().name;
+    stops_names_.ids.Set(name, id);
+    stop_buses_.push_back({});
+    stops_lat_.push_back(stop_coord.lat);
+    stops_lng_.push_back(stop_coord.lng);
+    const UnitVector vector = ToUnitVector(stop_coord);
+    stops_x_.push_back(vector.x);
+    stops_y_.push_back(vector.y);
+    stops_z_.push_back(vector.z);
+    if (is_index_current) {
+        spatial_index_.Insert(id, vector);
+    }
+    if (is_names_index_current) {
+        stops_index_.Insert(name);
+    }
+}
+
+void TransportCatalogue::MoveStop(std::string_view stop_name, const Coordinates& stop_coord) {
+    const StopId id = GetStopId(stop_name);
+    stops_.Mutable(id).coordinates = stop_coord;
+    stops_lat_.Mutable(id) = stop_coord.lat;
+    stops_lng_.Mutable(id) = stop_coord.lng;
+    const UnitVector vector = ToUnitVector(stop_coord);
+    stops_x_.Mutable(id) = vector.x;
+    stops_y_.Mutable(id) = vector.y;
+    stops_z_.Mutable(id) = vector.z;
+    if (IsSpatialIndexCurrent()) {
+        SpatialIndex& spatial_index = spatial_index_;
+        spatial_index.Erase(id);
+        spatial_index.Insert(id, vector);
+    }
+    //Географическое расстояние, а с ним извилистость маршрутов через остановку, изменилось
+    UpdateBusesInfo(id);
+}
+
+//Номер остановки - её позиция в stops_, поэтому последняя остановка переносится на место удалённой,
+//а её номер меняется в расстояниях, координатах, индексах и маршрутах
+void TransportCatalogue::RemoveStop(std::string_view stop_name) {
+    const StopId id = GetStopId(stop_name);
+    if (!stop_buses_[id].empty()) {
+        throw std::invalid_argument("Stop "s + std::string(stop_name) + " is used by bus "s + std::string(buses_[stop_buses_[id].front()].name));
+    }
+    UnfreezeStopsNames();
+    const bool is_index_current = IsSpatialIndexCurrent();
+    const StopId last_id = static_cast<StopId>(stops_.size() - 1);
+    distances_.EraseStop(id);
+    if (is_index_current) {
+        spatial_index_.Erase(id);
+    }
+    if (IsStopsIndexCurrent()) {
+        stops_index_.Erase(stops_[id].name);
+    }
+    stops_names_.ids.Erase(stops_[id].name);
+    if (id != last_id) {
+        const Stop last = stops_[last_id];
+        distances_.RenumberStop(last_id, id);
+        if (is_index_current) {
+            SpatialIndex& spatial_index = spatial_index_;
+            spatial_index.Erase(last_id);
+            spatial_index.Insert(id, GetUnitVector(last_id));
+        }
+        stops_.Mutable(id) = {last.name, last.coordinates, id};
+        stops_names_.ids.Set(stops_[id].name, id);
+        stops_lat_.Mutable(id) = stops_lat_[last_id];
+        stops_lng_.Mutable(id) = stops_lng_[last_id];
+        stops_x_.Mutable(id) = stops_x_[last_id];
+        stops_y_.Mutable(id) = stops_y_[last_id];
+        stops_z_.Mutable(id) = stops_z_[last_id];
+        for (BusId bus : stop_buses_[last_id]) {
+            const StopSequence sequence = stop_sequences_.Get(buses_[bus].stops);
+            std::vector<StopId> bus_stops(sequence.begin(), sequence.end());
+            std::replace(bus_stops.begin(), bus_stops.end(), last_id, id);
+            stop_sequences_.Set(buses_[bus].stops, bus_stops);
+        }
+        std::vector<BusId> last_buses = stop_buses_[last_id];
+        stop_buses_.Mutable(id) = std::move(last_buses);
+    }
+    stops_.pop_back();
+    stop_buses_.pop_back();
+    stops_lat_.pop_back();
+    stops_lng_.pop_back();
+    stops_x_.pop_back();
+    stops_y_.pop_back();
+    stops_z_.pop_back();
 }
 
 void TransportCatalogue::AddSpeedAndWait(double speed, double wait) {
@@ -50,6 +324,20 @@ void TransportCatalogue::AddSpeedAndWait(double speed, double wait) {
     bus_wait_time = wait;
 }
 
+void TransportCatalogue::Reserve(size_t stops_count) {
+    if (stops_names_.frozen == nullptr) {
+        stops_names_.ids.reserve(stops_count);
+    }
+    stops_.reserve(stops_count);
+    stop_buses_.reserve(stops_count);
+    stops_lat_.reserve(stops_count);
+    stops_lng_.reserve(stops_count);
+    stops_x_.reserve(stops_count);
+    stops_y_.reserve(stops_count);
+    stops_z_.reserve(stops_count);
+    distances_.Reserve(stops_count);
+}
+
 double TransportCatalogue::GetSpeed() const {
     return bus_speed;
 }
@@ -58,75 +346,273 @@ double TransportCatalogue::GetWaitTime() const {
     return bus_wait_time;
 }
 
-const std::deque<Stop>& TransportCatalogue::GetStops() const {
+const ChunkedVector<Stop>& TransportCatalogue::GetStops() const {
     return stops_;
 }
 
-const std::deque<Bus>& TransportCatalogue::GetBuses() const {
+const ChunkedVector<Bus>& TransportCatalogue::GetBuses() const {
     return buses_;
 }
 
-bool TransportCatalogue::GetIsRoundtrip(const std::string_view& name) const{
-    return is_roundtrip.at(name);
+const NameArena& TransportCatalogue::GetNames() const {
+    return *names_;
 }
 
-void TransportCatalogue::AddRoundtripInfo(const std::string_view& name, bool is_roundtrip_) {
-    is_roundtrip[name] = is_roundtrip_;
+const DistanceTable& TransportCatalogue::GetDistances() const {
+    return distances_;
 }
 
 const Bus* TransportCatalogue::FindBus(const std::string_view name) const {
-    auto it = buses_names.find(name);
-    if (it != buses_names.end()) {
-        return it->second;
-    }
-    return nullptr;
+    const std::optional<BusId> bus = FindBusId(name);
+    return bus ? &buses_[*bus] : nullptr;
 }
 
 const Stop* TransportCatalogue::FindStop(const std::string_view name) const {
-    auto it = stops_names.find(name);
-    if (it != stops_names.end()) {
-        return it->second;
+    const std::optional<StopId> stop = FindStopId(name);
+    return stop ? &stops_[*stop] : nullptr;
+}
+
+//Совершенный хеш даёт позицию и для чужого имени, поэтому имя в ней сравнивается
+std::optional<StopId> TransportCatalogue::FindStopId(std::string_view name) const {
+    return FindId(stops_names_, stops_, name);
+}
+
+std::optional<BusId> TransportCatalogue::FindBusId(std::string_view name) const {
+    return FindId(buses_names_, buses_, name);
+}
+
+StopId TransportCatalogue::GetStopId(std::string_view name) const {
+    const std::optional<StopId> stop = FindStopId(name);
+    if (!stop) {
+        throw std::out_of_range("Unknown stop "s + std::string(name));
     }
-    return nullptr;
+    return *stop;
 }
 
-std::optional<std::set<std::string_view>> TransportCatalogue::GetBusesForStop(const std::string_view name) const {
-    if (!stops_names.contains(name)) {
+BusId TransportCatalogue::GetBusId(std::string_view name) const {
+    const std::optional<BusId> bus = FindBusId(name);
+    if (!bus) {
+        throw std::out_of_range("Unknown bus "s + std::string(name));
+    }
+    return *bus;
+}
+
+void TransportCatalogue::FreezeNames() {
+    if (stops_names_.frozen == nullptr) {
+        FreezeIds(stops_names_, stops_);
+    }
+    if (buses_names_.frozen == nullptr) {
+        FreezeIds(buses_names_, buses_);
+    }
+}
+
+void TransportCatalogue::UnfreezeStopsNames() {
+    if (stops_names_.frozen != nullptr) {
+        UnfreezeIds(stops_names_, stops_);
+    }
+}
+
+void TransportCatalogue::UnfreezeBusesNames() {
+    if (buses_names_.frozen != nullptr) {
+        UnfreezeIds(buses_names_, buses_);
+    }
+}
+
+std::optional<std::pmr::set<std::string_view>> TransportCatalogue::GetBusesForStop(const std::string_view name, std::pmr::memory_resource* resource) const {
+    const std::optional<StopId> id = FindStopId(name);
+    if (!id) {
         return std::nullopt;
     }
-    std::set<std::string_view> buses_for_stop;
-    for (auto& bus : buses_) {
-        auto it = std::find_if(bus.stops.begin(), bus.stops.end(), [name](Stop* stop) { return stop->name == name; });
-        if (it != bus.stops.end()) {
-            buses_for_stop.insert(bus.name);
-        }
+    std::pmr::set<std::string_view> buses_for_stop(resource);
+    for (BusId bus : stop_buses_[*id]) {
+        buses_for_stop.insert(buses_[bus].name);
     }
     return buses_for_stop;
 }
 
+memory::Report TransportCatalogue::GetMemoryUsage() const {
+    memory::Report report;
+    report.push_back({"catalogue.stops", stops_.GetMemoryBytes(), stops_.size()});
+    report.push_back({"catalogue.buses", buses_.GetMemoryBytes(), buses_.size()});
+    memory::Usage bus_stops = stop_sequences_.GetMemoryUsage();
+    bus_stops.name = "catalogue.bus_stops";
+    report.push_back(std::move(bus_stops));
+    report.push_back(GetNamesMemoryUsage("catalogue.stops_names", stops_names_));
+    report.push_back(GetNamesMemoryUsage("catalogue.buses_names", buses_names_));
+    memory::Usage stop_buses{"catalogue.stop_buses", stop_buses_.GetMemoryBytes(), 0};
+    for (const std::vector<BusId>& buses : stop_buses_) {
+        stop_buses.bytes += memory::VectorBytes(buses);
+        stop_buses.elements += buses.size();
+    }
+    report.push_back(std::move(stop_buses));
+    memory::Usage distances = distances_.GetMemoryUsage();
+    distances.name = "catalogue.distances";
+    report.push_back(std::move(distances));
+    report.push_back({"catalogue.coordinates",
+                      stops_lat_.GetMemoryBytes() + stops_lng_.GetMemoryBytes()
+                          + stops_x_.GetMemoryBytes() + stops_y_.GetMemoryBytes() + stops_z_.GetMemoryBytes(),
+                      stops_lat_.size()});
+    memory::Usage spatial_index = spatial_index_.GetMemoryUsage();
+    spatial_index.name = "catalogue.spatial_index";
+    report.push_back(std::move(spatial_index));
+    memory::Usage stops_index = stops_index_.GetMemoryUsage();
+    stops_index.name = "catalogue.stops_index";
+    report.push_back(std::move(stops_index));
+    memory::Usage buses_index = buses_index_.GetMemoryUsage();
+    buses_index.name = "catalogue.buses_index";
+    report.push_back(std::move(buses_index));
+    for (memory::Usage& usage : names_->GetMemoryUsage()) {
+        usage.name = "catalogue.names." + usage.name;
+        report.push_back(std::move(usage));
+    }
+    return report;
+}
+
+bool TransportCatalogue::IsSpatialIndexCurrent() const {
+    return !stops_.empty() && spatial_index_.Size() == stops_.size();
+}
+
+bool TransportCatalogue::IsStopsIndexCurrent() const {
+    return !stops_.empty() && stops_index_.Size() == stops_.size();
+}
+
+bool TransportCatalogue::IsBusesIndexCurrent() const {
+    return !buses_.empty() && buses_index_.Size() == buses_.size();
+}
+
+void TransportCatalogue::BuildIndexes() {
+    std::vector<UnitVector> points;
+    points.reserve(stops_.size());
+    for (StopId id = 0; id < stops_.size(); ++id) {
+        points.push_back(GetUnitVector(id));
+    }
+    spatial_index_.Build(points);
+    std::vector<std::string_view> names;
+    names.reserve(stops_.size());
+    for (const Stop& stop : stops_) {
+        names.push_back(stop.name);
+    }
+    stops_index_.Build(names);
+    names.clear();
+    for (const Bus& bus : buses_) {
+        names.push_back(bus.name);
+    }
+    buses_index_.Build(names);
+    FreezeNames();
+}
+
+std::vector<std::pair<const Stop*, double>> TransportCatalogue::NearestStops(Coordinates coordinates, size_t count, double max_distance) const {
+    const UnitVector point = ToUnitVector(coordinates);
+    std::vector<std::pair<const Stop*, double>> result;
+    //До BuildIndexes индекса нет - перебираем все остановки
+    if (!IsSpatialIndexCurrent()) {
+        for (const Stop& stop : stops_) {
+            double distance = ComputeUnitDistance(point, GetUnitVector(stop.id));
+            if (distance <= max_distance) {
+                result.push_back({&stop, distance});
+            }
+        }
+        std::sort(result.begin(), result.end(), [](const auto& lhs, const auto& rhs) { return lhs.second < rhs.second; });
+        result.resize(std::min(result.size(), count));
+        return result;
+    }
+    for (const auto& [id, distance] : spatial_index_.FindNearest(point, count, max_distance)) {
+        result.push_back({&stops_[id], distance});
+    }
+    return result;
+}
+
+std::vector<std::string_view> TransportCatalogue::SuggestStops(std::string_view prefix, size_t limit) const {
+    if (!IsStopsIndexCurrent()) {
+        return FindNamesByPrefix(stops_, prefix, limit);
+    }
+    return stops_index_.FindByPrefix(prefix, limit);
+}
+
+std::vector<std::string_view> TransportCatalogue::SuggestBuses(std::string_view prefix, size_t limit) const {
+    if (!IsBusesIndexCurrent()) {
+        return FindNamesByPrefix(buses_, prefix, limit);
+    }
+    return buses_index_.FindByPrefix(prefix, limit);
+}
+
 std::optional<BusInfo> TransportCatalogue::GetBusInfo(const std::string_view name) const {
-    auto it = buses_names.find(name);
-    if (it == buses_names.end()) {
+    const Bus* bus = FindBus(name);
+    if (bus == nullptr) {
         return std::nullopt;
     }
-    std::unordered_set<Stop*> unique_stops;
+    return bus->info;
+}
+
+StopSequence TransportCatalogue::GetBusStops(const Bus& bus) const {
+    return stop_sequences_.Get(bus.stops);
+}
+
+RouteStops TransportCatalogue::GetRouteStops(const Bus& bus) const {
+    return {stops_, stop_sequences_.Get(bus.stops), bus.is_roundtrip};
+}
+
+void TransportCatalogue::SetStopsEncoding(StopSequencePool::Encoding encoding) {
+    stop_sequences_.SetEncoding(encoding);
+}
+
+BusesInfo TransportCatalogue::GetAllBusesInfo() const {
+    std::vector<const Bus*> buses;
+    buses.reserve(buses_.size());
+    for (const Bus& bus : buses_) {
+        buses.push_back(&bus);
+    }
+    std::sort(buses.begin(), buses.end(), [](const Bus* lhs, const Bus* rhs) { return lhs->name < rhs->name; });
+    BusesInfo result;
+    result.names.reserve(buses.size());
+    result.stops_on_route.reserve(buses.size());
+    result.unique_stops.reserve(buses.size());
+    result.length.reserve(buses.size());
+    result.curvature.reserve(buses.size());
+    for (const Bus* bus : buses) {
+        result.names.push_back(bus->name);
+        result.stops_on_route.push_back(bus->info.stops_on_route);
+        result.unique_stops.push_back(bus->info.unique_stops);
+        result.length.push_back(bus->info.length);
+        result.curvature.push_back(bus->info.curvature);
+    }
+    return result;
+}
+
+//Расстояния между соседними остановками маршрута должны быть добавлены до вызова
+BusInfo TransportCatalogue::ComputeBusInfo(const Bus& bus) const {
+    const StopSequence stops = GetBusStops(bus);
+    std::unordered_set<StopId> unique_stops;
+    std::vector<double> x;
+    std::vector<double> y;
+    std::vector<double> z;
+    x.reserve(stops.size());
+    y.reserve(stops.size());
+    z.reserve(stops.size());
     size_t amount = 0;
-    double length = 0;
     double real_length = 0;
-    Stop* last_stop = nullptr;
-    for (auto& stop_ptr : it->second->stops) {
-        if (amount) {
-            length += ComputeDistance(last_stop->coordinates, stop_ptr->coordinates);
-            real_length += TransportCatalogue::GetDistance(last_stop->name, stop_ptr->name).value();
+    std::optional<StopId> last_stop;
+    for (StopId stop : stops) {
+        if (last_stop) {
+            real_length += GetDistance(*last_stop, stop).value();
+            //Дорожное расстояние обратно может отличаться
+            if (!bus.is_roundtrip) {
+                real_length += GetDistance(stop, *last_stop).value();
+            }
         }
-        last_stop = stop_ptr;
-        if (unique_stops.contains(stop_ptr)) {
+        last_stop = stop;
+        x.push_back(stops_x_[stop]);
+        y.push_back(stops_y_[stop]);
+        z.push_back(stops_z_[stop]);
+        if (unique_stops.contains(stop)) {
             continue;
         }
-        unique_stops.insert(stop_ptr);
+        unique_stops.insert(stop);
         ++amount;
     }
-    return BusInfo{it->second->stops.size(), amount, real_length, real_length / length};
+    //Обратный ход проходит те же точки, поэтому географическая длина удваивается
+    double length = ComputePathDistance(x.data(), y.data(), z.data(), x.size()) * (bus.is_roundtrip ? 1 : 2);
+    return BusInfo{GetRouteStops(bus).size(), amount, real_length, real_length / length};
 }
 
 } //transport_catalogue
\ No newline at end of file
@@ -1,9 +1,19 @@
 #pragma once
 
+#include "copy_on_write.h"
 #include "geo.h"
 #include "domain.h"
+#include "distance_table.h"
+#include "memory_usage.h"
+#include "name_arena.h"
+#include "name_index.h"
+#include "perfect_hash.h"
+#include "spatial_index.h"
+#include "stop_sequence.h"
 
-#include <deque>
+#include <limits>
+#include <memory>
+#include <memory_resource>
 #include <optional>
 #include <set>
 #include <string>
@@ -13,46 +23,119 @@
 
 namespace transport_catalogue {
 
-struct BusInfo {
-    size_t stops_on_route{};
-    size_t unique_stops{};
-    double length{};
-    double curvature{};
-};
-
-class PairStopsHasher {
-public:
-    size_t operator()(const std::pair<Stop*, Stop*>& item) const {
-        return std::hash<const void*>{}(item.first) + 37 * std::hash<const void*>{}(item.second);
-    }
-};
-    
+//Все данные каталога лежат кусками, общими у его копий (см. copy_on_write.h): остановки, маршруты,
+//координаты, таблицы имён, строки расстояний, последовательности остановок маршрутов и индексы.
+//Изменение копирует только куски, которых оно касается, поэтому копия каталога стоит указателей
+//на куски, а версия после обновления - указателей и затронутых кусков.
 class TransportCatalogue {
-    std::unordered_map<std::pair<Stop*, Stop*>, int, PairStopsHasher> distances_;
-    std::unordered_map<std::string_view, Stop*> stops_names;
-    std::unordered_map<std::string_view, Bus*> buses_names;
-    std::unordered_map<std::string_view, bool> is_roundtrip;
-    std::deque<Stop> stops_;
-    std::deque<Bus> buses_;
-    double bus_speed;
-    double bus_wait_time;
+    //Совершенный хеш замороженных имён и номер по его позиции; не меняется, пока его держит каталог
+    struct FrozenNames {
+        PerfectHash hash;
+        std::vector<uint32_t> by_slot;
+    };
+    //Имена остановок или маршрутов: таблица, пока набор меняется, после заморозки - совершенный хеш
+    struct Names {
+        ChunkedHashMap<std::string_view, uint32_t> ids;
+        std::shared_ptr<const FrozenNames> frozen;
+    };
+
+    std::shared_ptr<NameArena> names_;
+    DistanceTable distances_;
+    Names stops_names_;
+    Names buses_names_;
+    ChunkedVector<Stop> stops_;
+    ChunkedVector<Bus> buses_;
+    StopSequencePool stop_sequences_; //Остановки всех маршрутов
+    ChunkedVector<std::vector<BusId>> stop_buses_; //Маршруты, проходящие через остановку, по StopId
+    //Координаты остановок по StopId, отдельными массивами для пакетного расчёта расстояний
+    ChunkedVector<double> stops_lat_;
+    ChunkedVector<double> stops_lng_;
+    //Единичные векторы остановок: расстояние между остановками - скалярное произведение и acos
+    ChunkedVector<double> stops_x_;
+    ChunkedVector<double> stops_y_;
+    ChunkedVector<double> stops_z_;
+    SpatialIndex spatial_index_;
+    NameIndex stops_index_; //Имена для подсказок
+    NameIndex buses_index_;
+    double bus_speed{};
+    double bus_wait_time{};
+
+    BusInfo ComputeBusInfo(const Bus& bus) const;
+    void SetBusStops(BusId bus, const std::vector<StopId>& stops, bool is_roundtrip);
+    void UnindexBus(BusId bus);
+    void UpdateBusesInfo(StopId stop); //Пересчитывает статистику маршрутов через остановку
+    bool IsSpatialIndexCurrent() const; //Индекс построен и поддерживается при изменениях
+    bool IsStopsIndexCurrent() const;
+    std::optional<StopId> FindStopId(std::string_view name) const;
+    std::optional<BusId> FindBusId(std::string_view name) const;
+    StopId GetStopId(std::string_view name) const; //std::out_of_range, если имени нет
+    BusId GetBusId(std::string_view name) const;
+    void UnfreezeStopsNames(); //Перед изменением набора имён возвращает таблицу
+    void UnfreezeBusesNames();
+    bool IsBusesIndexCurrent() const;
     
 public: 
+    TransportCatalogue();
+    //Каталоги с общей ареной не дублируют одинаковые имена
+    explicit TransportCatalogue(std::shared_ptr<NameArena> names);
+    //Копия делит с оригиналом все данные до их изменения и арену имён
+    TransportCatalogue(const TransportCatalogue& other) = default;
+    TransportCatalogue(TransportCatalogue&& other) = default;
+    TransportCatalogue& operator=(const TransportCatalogue& other) = delete;
+    TransportCatalogue& operator=(TransportCatalogue&& other) = default;
+
     void AddDistance(const std::string_view stop1_name, const std::string_view stop2_name, int distance);
+    void AddDistance(StopId stop1, StopId stop2, int distance);
     std::optional<int> GetDistance(const std::string_view stop1_name, const std::string_view stop2_name) const;
-    void AddBus(std::string bus_name, const std::vector<std::string_view>& stops);
-    void AddStop(std::string stop_name, const Coordinates& stop_coord);
+    std::optional<int> GetDistance(StopId stop1, StopId stop2) const;
+    double ComputeGeoDistance(StopId stop1, StopId stop2) const; //Расстояние по поверхности Земли
+    UnitVector GetUnitVector(StopId stop) const;
+    //stops - прямой ход маршрута, обратный ход некольцевого маршрута достраивается при обходе
+    void AddBus(std::string_view bus_name, const std::vector<std::string_view>& stops, bool is_roundtrip);
+    void AddBus(std::string_view bus_name, const std::vector<StopId>& stops, bool is_roundtrip);
+    void AddStop(std::string_view stop_name, const Coordinates& stop_coord);
     void AddSpeedAndWait(double speed, double wait);
+    //Изменение каталога на месте: имена, расстояния, статистика маршрутов и индексы
+    //обновляются за время, пропорциональное размеру изменения. Неизвестное имя - std::out_of_range.
+    void RemoveBus(std::string_view bus_name);
+    void UpdateBusStops(std::string_view bus_name, const std::vector<std::string_view>& stops, bool is_roundtrip);
+    void UpdateBusStops(std::string_view bus_name, const std::vector<StopId>& stops, bool is_roundtrip);
+    void MoveStop(std::string_view stop_name, const Coordinates& stop_coord);
+    //Остановку, через которую проходят маршруты, удалить нельзя - std::invalid_argument.
+    //Её номер получает последняя остановка.
+    void RemoveStop(std::string_view stop_name);
+    void Reserve(size_t stops_count); //Для загрузки каталога известного размера
     const Bus* FindBus(const std::string_view name) const;
     const Stop* FindStop(const std::string_view name) const;
     double GetSpeed() const;
     double GetWaitTime() const;
-    void AddRoundtripInfo(const std::string_view& name, bool is_roundtrip_);
-    bool GetIsRoundtrip(const std::string_view& name) const;
-    const std::deque<Stop>& GetStops() const;
-    const std::deque<Bus>& GetBuses() const;
-    std::optional<std::set<std::string_view>> GetBusesForStop(const std::string_view name) const;
+    const ChunkedVector<Stop>& GetStops() const; //По StopId
+    const ChunkedVector<Bus>& GetBuses() const;
+    const NameArena& GetNames() const;
+    const DistanceTable& GetDistances() const;
+    std::optional<std::pmr::set<std::string_view>> GetBusesForStop(const std::string_view name,
+                                                                   std::pmr::memory_resource* resource = std::pmr::get_default_resource()) const;
     std::optional<BusInfo> GetBusInfo(const std::string_view name) const;
+    StopSequence GetBusStops(const Bus& bus) const; //Номера остановок прямого хода
+    RouteStops GetRouteStops(const Bus& bus) const; //Остановки в порядке проезда
+    //Сжатые последовательности занимают меньше памяти, но обходятся медленнее
+    void SetStopsEncoding(StopSequencePool::Encoding encoding);
+    //Статистика всех маршрутов по возрастанию имени; считается при добавлении маршрутов, здесь только собирается
+    BusesInfo GetAllBusesInfo() const;
+    //Память по структурам каталога; арена имён может быть общей с другими каталогами
+    memory::Report GetMemoryUsage() const;
+
+    //Строит вспомогательные индексы и замораживает имена; вызывается после загрузки каталога
+    void BuildIndexes();
+    //Заменяет таблицы имён совершенным хешем: поиск - один хеш и одно сравнение.
+    //Добавление или удаление остановки или маршрута возвращает соответствующую таблицу.
+    void FreezeNames();
+    //Не больше count ближайших к точке остановок в радиусе max_distance метров и расстояния до них
+    std::vector<std::pair<const Stop*, double>> NearestStops(Coordinates coordinates, size_t count,
+                                                             double max_distance = std::numeric_limits<double>::infinity()) const;
+    //Не больше limit имён, начинающихся с prefix без учёта регистра, в алфавитном порядке
+    std::vector<std::string_view> SuggestStops(std::string_view prefix, size_t limit) const;
+    std::vector<std::string_view> SuggestBuses(std::string_view prefix, size_t limit) const;
 };
 
 } //transport_catalogue
\ No newline at end of file
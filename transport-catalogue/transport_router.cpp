@@ -16,31 +16,35 @@ DirectedWeightedGraph<double> RoutesManager::MakeRoutesGraph(const transport_cat
     const auto& buses = catalogue.GetBuses();
     std::unordered_set<std::string_view> self_edge_stop;
     for (const auto& bus : buses) {
-        bool is_roundtrip = catalogue.GetIsRoundtrip(bus.name);
-        auto stops_names_vector = (is_roundtrip ? bus.stops : std::vector<transport_catalogue::Stop*>(bus.stops.begin(), bus.stops.begin() + bus.stops.size() / 2 + 1));
-        for (auto it_1 = stops_names_vector.begin(); it_1 != stops_names_vector.end(); ++it_1) {
-            if (!self_edge_stop.contains((*it_1)->name)) {
-                size_t edge_id = graph.AddEdge({static_cast<size_t>(graph.stops_id[(*it_1)->name]) - 1, static_cast<size_t>(graph.stops_id[(*it_1)->name]), catalogue.GetWaitTime()});
+        const bool is_roundtrip = bus.is_roundtrip;
+        const auto stops_names_vector = catalogue.GetBusStops(bus);
+        //Итератор сжатой последовательности только двунаправленный, поэтому число пролётов
+        //считается по номерам позиций, которые идут рядом с итераторами
+        size_t index_1 = 0;
+        for (auto it_1 = stops_names_vector.begin(); it_1 != stops_names_vector.end(); ++it_1, ++index_1) {
+            const std::string_view stop_1 = stops[*it_1].name;
+            if (!self_edge_stop.contains(stop_1)) {
+                size_t edge_id = graph.AddEdge({static_cast<size_t>(graph.stops_id[stop_1]) - 1, static_cast<size_t>(graph.stops_id[stop_1]), catalogue.GetWaitTime()});
                 graph.edges_info[edge_id] = {"", 0}; 
-                self_edge_stop.insert((*it_1)->name);            
+                self_edge_stop.insert(stop_1);            
             }
             double sum_time = 0;
-            for (auto it_2 = std::next(it_1); it_2 != stops_names_vector.end(); ++it_2) {
-                if ((is_roundtrip) and (it_1 == stops_names_vector.begin()) and (it_2 == std::prev(stops_names_vector.end()))) {
+            size_t index_2 = index_1 + 1;
+            for (auto it_2 = std::next(it_1); it_2 != stops_names_vector.end(); ++it_2, ++index_2) {
+                if ((is_roundtrip) and (index_1 == 0) and (index_2 + 1 == stops_names_vector.size())) {
                     break;
                 }
-                sum_time += catalogue.GetDistance((*std::prev(it_2))->name, (*it_2)->name).value() / (catalogue.GetSpeed() * meters_in_kilometer / second_in_minute);
-                size_t edge_id = graph.AddEdge({static_cast<size_t>(graph.stops_id[(*it_1)->name]), static_cast<size_t>(graph.stops_id[(*it_2)->name]) - 1, sum_time});
-                auto dist = std::distance(it_1, it_2);
-                graph.edges_info[edge_id] = {bus.name, static_cast<int>(dist > 0 ? dist : dist * -1)};
+                sum_time += catalogue.GetDistance(*std::prev(it_2), *it_2).value() / (catalogue.GetSpeed() * meters_in_kilometer / second_in_minute);
+                size_t edge_id = graph.AddEdge({static_cast<size_t>(graph.stops_id[stop_1]), static_cast<size_t>(graph.stops_id[stops[*it_2].name]) - 1, sum_time});
+                graph.edges_info[edge_id] = {bus.name, static_cast<int>(index_2 - index_1)};
             }
-            if ((!is_roundtrip) and (it_1 != stops_names_vector.begin())) {
+            if ((!is_roundtrip) and (index_1 != 0)) {
                 double sum_time_back = 0;
-                for (auto it_3 = it_1; it_3 != stops_names_vector.begin(); --it_3) {
-                    sum_time_back += catalogue.GetDistance((*it_3)->name, (*std::prev(it_3))->name).value() / (catalogue.GetSpeed() * meters_in_kilometer / second_in_minute);
-                    size_t edge_id = graph.AddEdge({static_cast<size_t>(graph.stops_id[(*it_1)->name]), static_cast<size_t>(graph.stops_id[(*std::prev(it_3))->name]) - 1, sum_time_back});
-                    auto dist = std::distance(it_1, std::prev(it_3));
-                    graph.edges_info[edge_id] = {bus.name, static_cast<int>(dist > 0 ? dist : dist * -1)};
+                size_t index_3 = index_1;
+                for (auto it_3 = it_1; index_3 != 0; --it_3, --index_3) {
+                    sum_time_back += catalogue.GetDistance(*it_3, *std::prev(it_3)).value() / (catalogue.GetSpeed() * meters_in_kilometer / second_in_minute);
+                    size_t edge_id = graph.AddEdge({static_cast<size_t>(graph.stops_id[stop_1]), static_cast<size_t>(graph.stops_id[stops[*std::prev(it_3)].name]) - 1, sum_time_back});
+                    graph.edges_info[edge_id] = {bus.name, static_cast<int>(index_1 - (index_3 - 1))};
                 }        
             }
         }
@@ -48,12 +52,24 @@ DirectedWeightedGraph<double> RoutesManager::MakeRoutesGraph(const transport_cat
     return graph;
 }
 
-std::optional<RouteInfo> RoutesManager::GetRoute(std::string_view from, std::string_view to) const {
-    auto route_info = router.BuildRoute(static_cast<size_t>(graph.stops_id.at(from)) - 1, static_cast<size_t>(graph.stops_id.at(to)) - 1);
+size_t RoutesManager::EstimateMemoryUsage(const transport_catalogue::TransportCatalogue& catalogue) {
+    //Вершины ожидания и посадки на каждую остановку
+    return Router<double>::EstimateMemoryUsage(2 * catalogue.GetStops().size());
+}
+
+memory::Report RoutesManager::GetMemoryUsage() const {
+    memory::Report report = graph.GetMemoryUsage();
+    report.push_back(router.GetMemoryUsage());
+    return report;
+}
+
+std::optional<RouteInfo> RoutesManager::GetRoute(std::string_view from, std::string_view to, std::pmr::memory_resource* resource) const {
+    auto route_info = router.BuildRoute(static_cast<size_t>(graph.stops_id.at(from)) - 1, static_cast<size_t>(graph.stops_id.at(to)) - 1, resource);
     if (!route_info.has_value()) {
         return std::nullopt;
     }
-    std::vector<std::variant<BusRiding, Waiting>> route_units;
+    std::pmr::vector<std::variant<BusRiding, Waiting>> route_units(resource);
+    route_units.reserve(route_info.value().edges.size());
     for (auto item : route_info.value().edges) {
         if (graph.GetEdge(item).from % 2 == 0) {
             route_units.push_back(Waiting{graph.stops_name.at(graph.GetEdge(item).to), graph.GetEdge(item).weight});
@@ -62,7 +78,7 @@ std::optional<RouteInfo> RoutesManager::GetRoute(std::string_view from, std::str
             route_units.push_back(BusRiding{graph.edges_info.at(item).bus_name, graph.edges_info.at(item).stops_count, graph.GetEdge(item).weight});         
         } 
     }
-    return RouteInfo{route_info.value().weight, route_units};
+    return RouteInfo{route_info.value().weight, std::move(route_units)};
 }
 
 }
\ No newline at end of file
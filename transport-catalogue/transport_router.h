@@ -1,8 +1,11 @@
+#pragma once
+
 #include "graph.h"
 #include "router.h"
 #include "domain.h"
 #include "transport_catalogue.h"
 
+#include <memory_resource>
 #include <optional>
 #include <string_view>
 #include <variant>
@@ -22,7 +25,7 @@ struct Waiting {
 
 struct RouteInfo {
 	double total_time;
-	std::vector<std::variant<BusRiding, Waiting>> route_units;
+	std::pmr::vector<std::variant<BusRiding, Waiting>> route_units;
 };
 
 class RoutesManager {
@@ -34,7 +37,12 @@ class RoutesManager {
 public:
 	RoutesManager(const transport_catalogue::TransportCatalogue& catalogue) : graph(MakeRoutesGraph(catalogue)), router(graph) {}
 
-	std::optional<RouteInfo> GetRoute(std::string_view from, std::string_view to) const;
+	//Временные массивы маршрута берутся из resource, например из арены запроса
+	std::optional<RouteInfo> GetRoute(std::string_view from, std::string_view to,
+	                                  std::pmr::memory_resource* resource = std::pmr::get_default_resource()) const;
+	memory::Report GetMemoryUsage() const; //Граф и матрица маршрутизатора
+	//Размер матрицы маршрутизатора для каталога, до её построения
+	static size_t EstimateMemoryUsage(const transport_catalogue::TransportCatalogue& catalogue);
 };
 
 }
\ No newline at end of file